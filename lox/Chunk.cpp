@@ -0,0 +1,182 @@
+#include "Chunk.h"
+#include <cassert>
+#include <sstream>
+#include <iomanip>
+
+std::string toString(OpCode opCode) noexcept {
+    switch (opCode) {
+#define LOX_OPCODE_NAME(name) case OpCode::name: return #name;
+        LOX_OPCODES(LOX_OPCODE_NAME)
+#undef LOX_OPCODE_NAME
+    default: return "Unknown opcode";
+    }
+}
+
+void Chunk::write(OpCode opCode) {
+    mCode.push_back(static_cast<std::uint8_t>(opCode));
+}
+
+void Chunk::write(std::uint8_t byte) {
+    mCode.push_back(byte);
+}
+
+void Chunk::writeShort(int value) {
+    assert(value >= 0 && value <= UINT16_MAX && "Chunk::writeShort: value out of range");
+    mCode.push_back(static_cast<std::uint8_t>((value >> 8) & 0xff));
+    mCode.push_back(static_cast<std::uint8_t>(value & 0xff));
+}
+
+void Chunk::patchShort(int offset, int value) {
+    assert(value >= 0 && value <= UINT16_MAX && "Chunk::patchShort: value out of range");
+    mCode[offset] = static_cast<std::uint8_t>((value >> 8) & 0xff);
+    mCode[offset + 1] = static_cast<std::uint8_t>(value & 0xff);
+}
+
+int Chunk::addConstant(Object const& value) {
+    mConstants.push_back(value);
+    return static_cast<int>(mConstants.size()) - 1;
+}
+
+int Chunk::addToken(Token const& token) {
+    mTokens.push_back(token);
+    return static_cast<int>(mTokens.size()) - 1;
+}
+
+int Chunk::addFunction(std::shared_ptr<CompiledFunction const> const& function) {
+    assert(function && "Chunk::addFunction: function cannot be nullptr");
+    mFunctions.push_back(function);
+    return static_cast<int>(mFunctions.size()) - 1;
+}
+
+namespace {
+
+    class Disassembler {
+    public:
+        Disassembler(CompiledFunction const& function, std::ostringstream& out) : mChunk(function.chunk), mOut(out) {
+            mOut << "== " << (function.name.empty() ? "<script>" : function.name) << " ==\n";
+        }
+
+        void disassemble() {
+            while (mOffset < static_cast<int>(mChunk.code().size())) {
+                instruction();
+            }
+        }
+
+        std::vector<CompiledFunction const*> const& nestedFunctions() const { return mFunctions; }
+
+    private:
+        int byte() { return mChunk.code()[mOffset++]; }
+        int shortOperand() { auto const value = (mChunk.code()[mOffset] << 8) | mChunk.code()[mOffset + 1]; mOffset += 2; return value; }
+        std::string_view token() { return mChunk.tokens()[shortOperand()].lexeme(); }
+
+        void instruction() {
+            mOut << std::setw(4) << std::setfill('0') << mOffset << " ";
+            auto const opCode = static_cast<OpCode>(byte());
+            mOut << std::left << std::setw(16) << std::setfill(' ') << toString(opCode) << std::right;
+
+            switch (opCode) {
+            case OpCode::CONSTANT:
+                mOut << mChunk.constants()[shortOperand()].toString();
+                break;
+            case OpCode::GET_LOCAL: [[fallthrough]];
+            case OpCode::SET_LOCAL: [[fallthrough]];
+            case OpCode::GET_UPVALUE: [[fallthrough]];
+            case OpCode::SET_UPVALUE:
+                mOut << byte();
+                break;
+            case OpCode::GET_GLOBAL: [[fallthrough]];
+            case OpCode::DEFINE_GLOBAL: [[fallthrough]];
+            case OpCode::SET_GLOBAL: [[fallthrough]];
+            case OpCode::GET_PROPERTY: [[fallthrough]];
+            case OpCode::SET_PROPERTY: [[fallthrough]];
+            case OpCode::GET_SUPER: [[fallthrough]];
+            case OpCode::INHERIT:
+                mOut << "'" << token() << "'";
+                break;
+            case OpCode::GREATER: [[fallthrough]];
+            case OpCode::GREATER_EQUAL: [[fallthrough]];
+            case OpCode::LESS: [[fallthrough]];
+            case OpCode::LESS_EQUAL: [[fallthrough]];
+            case OpCode::ADD: [[fallthrough]];
+            case OpCode::SUBTRACT: [[fallthrough]];
+            case OpCode::MULTIPLY: [[fallthrough]];
+            case OpCode::DIVIDE: [[fallthrough]];
+            case OpCode::NEGATE:
+                shortOperand();
+                break;
+            case OpCode::JUMP: [[fallthrough]];
+            case OpCode::JUMP_IF_FALSE: {
+                auto const jump = shortOperand();
+                mOut << "-> " << mOffset + jump;
+                break;
+            }
+            case OpCode::LOOP: {
+                auto const jump = shortOperand();
+                mOut << "-> " << mOffset - jump;
+                break;
+            }
+            case OpCode::ADD_LOCAL: [[fallthrough]];
+            case OpCode::SUBTRACT_LOCAL:
+                mOut << byte() << " ";
+                mOut << mChunk.constants()[shortOperand()].toString();
+                shortOperand();
+                break;
+            case OpCode::JUMP_IF_NOT_LESS: [[fallthrough]];
+            case OpCode::JUMP_IF_NOT_LESS_EQUAL: [[fallthrough]];
+            case OpCode::JUMP_IF_NOT_GREATER: [[fallthrough]];
+            case OpCode::JUMP_IF_NOT_GREATER_EQUAL: {
+                shortOperand();
+                auto const jump = shortOperand();
+                mOut << "-> " << mOffset + jump;
+                break;
+            }
+            case OpCode::CALL:
+                mOut << byte();
+                shortOperand();
+                break;
+            case OpCode::CLOSURE: {
+                auto const& function = *mChunk.functions()[shortOperand()];
+                mOut << "<fn " << function.name << ">";
+                for (int i = 0; i != function.upvalueCount; ++i) {
+                    auto const isLocal = byte();
+                    auto const index = byte();
+                    mOut << (isLocal ? " local " : " upvalue ") << index;
+                }
+                mFunctions.push_back(&function);
+                break;
+            }
+            case OpCode::CLASS: {
+                mOut << "'" << token() << "'";
+                auto const methodCount = byte();
+                if (byte()) mOut << " <";
+                for (int i = 0; i != methodCount; ++i) {
+                    mOut << " " << token();
+                }
+                break;
+            }
+            default:
+                break;
+            }
+            mOut << "\n";
+        }
+
+        Chunk const& mChunk;
+        std::ostringstream& mOut;
+        int mOffset = 0;
+        std::vector<CompiledFunction const*> mFunctions;
+    };
+
+    void disassemble(CompiledFunction const& function, std::ostringstream& out) {
+        auto disassembler = Disassembler(function, out);
+        disassembler.disassemble();
+        for (auto const* nested : disassembler.nestedFunctions()) {
+            disassemble(*nested, out);
+        }
+    }
+}
+
+std::string disassemble(CompiledFunction const& function) {
+    auto out = std::ostringstream();
+    disassemble(function, out);
+    return out.str();
+}
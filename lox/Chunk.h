@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Object.h"
+#include "Token.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// X-macro list of all opcodes, so that the enum, the disassembler and the
+// computed-goto dispatch table in the VM are always in sync.
+#define LOX_OPCODES(X) \
+    X(CONSTANT)                  \
+    X(NIL)                       \
+    X(TRUE)                      \
+    X(FALSE)                     \
+    X(POP)                       \
+    X(GET_LOCAL)                 \
+    X(SET_LOCAL)                 \
+    X(GET_GLOBAL)                \
+    X(DEFINE_GLOBAL)             \
+    X(SET_GLOBAL)                \
+    X(GET_UPVALUE)               \
+    X(SET_UPVALUE)               \
+    X(GET_PROPERTY)              \
+    X(SET_PROPERTY)              \
+    X(GET_SUPER)                 \
+    X(EQUAL)                     \
+    X(NOT_EQUAL)                 \
+    X(GREATER)                   \
+    X(GREATER_EQUAL)             \
+    X(LESS)                      \
+    X(LESS_EQUAL)                \
+    X(ADD)                       \
+    X(SUBTRACT)                  \
+    X(MULTIPLY)                  \
+    X(DIVIDE)                    \
+    X(NOT)                       \
+    X(NEGATE)                    \
+    X(PRINT)                     \
+    X(JUMP)                      \
+    X(JUMP_IF_FALSE)             \
+    X(LOOP)                      \
+    X(CALL)                      \
+    X(CLOSURE)                   \
+    X(CLOSE_UPVALUE)             \
+    X(RETURN)                    \
+    X(INHERIT)                   \
+    X(CLASS)                     \
+    X(ADD_LOCAL)                 \
+    X(SUBTRACT_LOCAL)            \
+    X(JUMP_IF_NOT_LESS)          \
+    X(JUMP_IF_NOT_LESS_EQUAL)    \
+    X(JUMP_IF_NOT_GREATER)       \
+    X(JUMP_IF_NOT_GREATER_EQUAL)
+
+enum class OpCode : std::uint8_t {
+#define LOX_OPCODE_ENUM(name) name,
+    LOX_OPCODES(LOX_OPCODE_ENUM)
+#undef LOX_OPCODE_ENUM
+};
+
+std::string toString(OpCode opCode) noexcept;
+
+struct CompiledFunction;
+
+// Operands are encoded big-endian after the opcode: slots, argument counts and
+// upvalue descriptors take one byte; constants, tokens, functions and jumps two.
+// The superinstructions fuse common sequences: ADD_LOCAL and SUBTRACT_LOCAL
+// (slot, constant, token) step a local by a constant and push it, and the
+// JUMP_IF_NOT_ comparisons (token, jump) pop two numbers and jump unless the
+// comparison holds.
+class Chunk {
+public:
+    void write(OpCode opCode);
+    void write(std::uint8_t byte);
+    void writeShort(int value);
+    void patchShort(int offset, int value);
+
+    int addConstant(Object const& value);
+    int addToken(Token const& token);
+    int addFunction(std::shared_ptr<CompiledFunction const> const& function);
+
+    std::vector<std::uint8_t> const& code() const { return mCode; }
+    std::vector<Object> const& constants() const { return mConstants; }
+    std::vector<Token> const& tokens() const { return mTokens; }
+    std::vector<std::shared_ptr<CompiledFunction const>> const& functions() const { return mFunctions; }
+
+private:
+    std::vector<std::uint8_t> mCode;
+    std::vector<Object> mConstants;
+    std::vector<Token> mTokens;
+    std::vector<std::shared_ptr<CompiledFunction const>> mFunctions;
+};
+
+struct CompiledFunction {
+    std::string name;
+    int arity = 0;
+    int upvalueCount = 0;
+    bool isMethod = false;
+    Chunk chunk;
+};
+
+std::string disassemble(CompiledFunction const& function);
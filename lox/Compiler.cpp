@@ -0,0 +1,629 @@
+#include "Compiler.h"
+#include "Chunk.h"
+#include "Dispatcher.h"
+#include "Expr.h"
+#include "Stmt.h"
+#include "Token.h"
+#include "TokenType.h"
+#include "Lox.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct CompileError {
+        int line;
+        std::string message;
+    };
+
+    enum class FunctionType {
+        SCRIPT, FUNCTION, INITIALIZER, METHOD
+    };
+
+    struct Local {
+        std::string_view name; // views the declaration's token
+        int depth;
+        bool isCaptured = false;
+    };
+
+    struct Upvalue {
+        int index;
+        bool isLocal;
+    };
+
+    struct FunctionContext {
+        FunctionContext(FunctionContext* enclosing, FunctionType type) : enclosing(enclosing), type(type), function(std::make_shared<CompiledFunction>()) {
+            // Slot zero holds 'this' for methods and is reserved otherwise.
+            locals.push_back({ type == FunctionType::METHOD || type == FunctionType::INITIALIZER ? "this" : "", 0 });
+        }
+
+        FunctionContext* enclosing;
+        FunctionType type;
+        std::shared_ptr<CompiledFunction> function;
+        std::vector<Local> locals;
+        std::vector<Upvalue> upvalues;
+        int scopeDepth = 0;
+        int line = 0;
+    };
+
+    void compile(Stmt const& stmt, FunctionContext& context);
+    void compile(Expr const& expr, FunctionContext& context);
+
+    // Emitting code:
+
+    Chunk& chunk(FunctionContext& context) {
+        return context.function->chunk;
+    }
+
+    void emit(OpCode opCode, FunctionContext& context) {
+        chunk(context).write(opCode);
+    }
+
+    void emitByte(int byte, FunctionContext& context) {
+        chunk(context).write(static_cast<std::uint8_t>(byte));
+    }
+
+    void emitShortOperand(int index, std::string const& what, FunctionContext& context) {
+        if (index > UINT16_MAX) throw CompileError{ context.line, "Too many " + what + " in one chunk." };
+        chunk(context).writeShort(index);
+    }
+
+    void emitToken(Token const& token, FunctionContext& context) {
+        context.line = token.line();
+        emitShortOperand(chunk(context).addToken(token), "tokens", context);
+    }
+
+    void emitConstant(Object const& value, FunctionContext& context) {
+        emit(OpCode::CONSTANT, context);
+        emitShortOperand(chunk(context).addConstant(value), "constants", context);
+    }
+
+    int emitJump(OpCode opCode, FunctionContext& context) {
+        emit(opCode, context);
+        chunk(context).writeShort(UINT16_MAX);
+        return static_cast<int>(chunk(context).code().size()) - 2;
+    }
+
+    void patchJump(int offset, FunctionContext& context) {
+        auto const jump = static_cast<int>(chunk(context).code().size()) - offset - 2;
+        if (jump > UINT16_MAX) throw CompileError{ context.line, "Too much code to jump over." };
+        chunk(context).patchShort(offset, jump);
+    }
+
+    void emitLoop(int loopStart, FunctionContext& context) {
+        emit(OpCode::LOOP, context);
+        auto const offset = static_cast<int>(chunk(context).code().size()) - loopStart + 2;
+        if (offset > UINT16_MAX) throw CompileError{ context.line, "Loop body too large." };
+        chunk(context).writeShort(offset);
+    }
+
+    void emitReturn(FunctionContext& context) {
+        if (context.type == FunctionType::INITIALIZER) {
+            emit(OpCode::GET_LOCAL, context);
+            emitByte(0, context);
+        }
+        else {
+            emit(OpCode::NIL, context);
+        }
+        emit(OpCode::RETURN, context);
+    }
+
+    void emitSetResult(FunctionContext& context) {
+        emit(OpCode::SET_LOCAL, context);
+        emitByte(0, context);
+        emit(OpCode::POP, context);
+    }
+
+    // Scopes and variables:
+
+    void beginScope(FunctionContext& context) {
+        ++context.scopeDepth;
+    }
+
+    void endScope(FunctionContext& context) {
+        --context.scopeDepth;
+        while (!context.locals.empty() && context.locals.back().depth > context.scopeDepth) {
+            emit(context.locals.back().isCaptured ? OpCode::CLOSE_UPVALUE : OpCode::POP, context);
+            context.locals.pop_back();
+        }
+    }
+
+    void addLocal(std::string_view name, FunctionContext& context) {
+        if (context.locals.size() > UINT8_MAX) throw CompileError{ context.line, "Too many local variables in function." };
+        context.locals.push_back({ name, -1 });
+    }
+
+    void markInitialized(FunctionContext& context) {
+        if (context.scopeDepth == 0) return;
+        context.locals.back().depth = context.scopeDepth;
+    }
+
+    void declareVariable(Token const& name, FunctionContext& context) {
+        if (context.scopeDepth == 0) return;
+        context.line = name.line();
+        addLocal(name.lexeme(), context);
+    }
+
+    void defineVariable(Token const& name, FunctionContext& context) {
+        if (context.scopeDepth > 0) {
+            markInitialized(context);
+            return;
+        }
+        emit(OpCode::DEFINE_GLOBAL, context);
+        emitToken(name, context);
+    }
+
+    int resolveLocal(std::string_view name, FunctionContext& context) {
+        for (auto i = static_cast<int>(context.locals.size()) - 1; i >= 0; --i) {
+            if (context.locals[i].name == name) return i;
+        }
+        return -1;
+    }
+
+    int addUpvalue(int index, bool isLocal, FunctionContext& context) {
+        for (auto i = 0; i != static_cast<int>(context.upvalues.size()); ++i) {
+            if (context.upvalues[i].index == index && context.upvalues[i].isLocal == isLocal) return i;
+        }
+        if (context.upvalues.size() > UINT8_MAX) throw CompileError{ context.line, "Too many closure variables in function." };
+        context.upvalues.push_back({ index, isLocal });
+        return static_cast<int>(context.upvalues.size()) - 1;
+    }
+
+    int resolveUpvalue(std::string_view name, FunctionContext& context) {
+        if (!context.enclosing) return -1;
+
+        if (auto const local = resolveLocal(name, *context.enclosing); local != -1) {
+            context.enclosing->locals[local].isCaptured = true;
+            return addUpvalue(local, true, context);
+        }
+
+        if (auto const upvalue = resolveUpvalue(name, *context.enclosing); upvalue != -1) {
+            return addUpvalue(upvalue, false, context);
+        }
+
+        return -1;
+    }
+
+    void namedVariable(Token const& name, bool assign, FunctionContext& context) {
+        context.line = name.line();
+        if (auto const local = resolveLocal(name.lexeme(), context); local != -1) {
+            emit(assign ? OpCode::SET_LOCAL : OpCode::GET_LOCAL, context);
+            emitByte(local, context);
+        }
+        else if (auto const upvalue = resolveUpvalue(name.lexeme(), context); upvalue != -1) {
+            emit(assign ? OpCode::SET_UPVALUE : OpCode::GET_UPVALUE, context);
+            emitByte(upvalue, context);
+        }
+        else {
+            emit(assign ? OpCode::SET_GLOBAL : OpCode::GET_GLOBAL, context);
+            emitToken(name, context);
+        }
+    }
+
+    void compileFunction(FunctionStmt const& stmt, FunctionType type, std::string_view className, FunctionContext& context) {
+        auto inner = FunctionContext(&context, type);
+        inner.line = stmt.name().line();
+        inner.function->name = className.empty() ? std::string(stmt.name().lexeme()) : std::string(className) + "::" + std::string(stmt.name().lexeme());
+        inner.function->arity = static_cast<int>(stmt.parameters().size());
+        inner.function->isMethod = type == FunctionType::METHOD || type == FunctionType::INITIALIZER;
+
+        beginScope(inner);
+        for (auto const& param : stmt.parameters()) {
+            declareVariable(param, inner);
+            markInitialized(inner);
+        }
+        compile(stmt.body(), inner);
+        emitReturn(inner);
+
+        inner.function->upvalueCount = static_cast<int>(inner.upvalues.size());
+
+        emit(OpCode::CLOSURE, context);
+        emitShortOperand(chunk(context).addFunction(inner.function), "functions", context);
+        for (auto const& upvalue : inner.upvalues) {
+            emitByte(upvalue.isLocal ? 1 : 0, context);
+            emitByte(upvalue.index, context);
+        }
+    }
+
+    // Statements:
+
+    void compileExpressionStmt(ExpressionStmt const& stmt, FunctionContext& context) {
+        compile(stmt.expression(), context);
+        emit(OpCode::POP, context);
+    }
+
+    void compilePrintStmt(PrintStmt const& stmt, FunctionContext& context) {
+        compile(stmt.expression(), context);
+        emit(OpCode::PRINT, context);
+    }
+
+    void compileVarStmt(VarStmt const& stmt, FunctionContext& context) {
+        declareVariable(stmt.name(), context);
+        if (stmt.initializer()) {
+            compile(*stmt.initializer(), context);
+        }
+        else {
+            emit(OpCode::NIL, context);
+        }
+        defineVariable(stmt.name(), context);
+    }
+
+    void compileBlockStmt(BlockStmt const& stmt, FunctionContext& context) {
+        beginScope(context);
+        for (auto const* statement : stmt.statements()) {
+            compile(*statement, context);
+        }
+        endScope(context);
+    }
+
+    // A jump taken when a condition is false. Comparisons compile to a single
+    // compare-and-branch that pops its operands; other conditions are left on
+    // the stack by JUMP_IF_FALSE, to be popped on either path.
+    struct ConditionJump {
+        int offset;
+        bool leavesCondition;
+    };
+
+    ConditionJump compileConditionJump(Expr const& condition, FunctionContext& context) {
+        if (condition.kind() == ExprKind::BINARY) {
+            auto const& comparison = static_cast<BinaryExpr const&>(condition);
+            auto const opCode = [&]() -> std::optional<OpCode> {
+                switch (comparison.operatr().tokenType()) {
+                case TokenType::LESS: return OpCode::JUMP_IF_NOT_LESS;
+                case TokenType::LESS_EQUAL: return OpCode::JUMP_IF_NOT_LESS_EQUAL;
+                case TokenType::GREATER: return OpCode::JUMP_IF_NOT_GREATER;
+                case TokenType::GREATER_EQUAL: return OpCode::JUMP_IF_NOT_GREATER_EQUAL;
+                default: return std::nullopt;
+                }
+            }();
+            if (opCode) {
+                compile(comparison.left(), context);
+                compile(comparison.right(), context);
+                emit(*opCode, context);
+                emitToken(comparison.operatr(), context);
+                chunk(context).writeShort(UINT16_MAX);
+                return { static_cast<int>(chunk(context).code().size()) - 2, false };
+            }
+        }
+        compile(condition, context);
+        return { emitJump(OpCode::JUMP_IF_FALSE, context), true };
+    }
+
+    void popCondition(ConditionJump const& jump, FunctionContext& context) {
+        if (jump.leavesCondition) emit(OpCode::POP, context);
+    }
+
+    void compileIfStmt(IfStmt const& stmt, FunctionContext& context) {
+        auto const thenJump = compileConditionJump(stmt.condition(), context);
+        popCondition(thenJump, context);
+        compile(stmt.thenBranch(), context);
+        auto const elseJump = emitJump(OpCode::JUMP, context);
+        patchJump(thenJump.offset, context);
+        popCondition(thenJump, context);
+        if (auto const elseBranch = stmt.elseBranch()) {
+            compile(*elseBranch, context);
+        }
+        patchJump(elseJump, context);
+    }
+
+    void compileWhileStmt(WhileStmt const& stmt, FunctionContext& context) {
+        auto const loopStart = static_cast<int>(chunk(context).code().size());
+        if (stmt.isEndless()) {
+            compile(stmt.body(), context);
+            emitLoop(loopStart, context);
+            return;
+        }
+        auto const exitJump = compileConditionJump(stmt.condition(), context);
+        popCondition(exitJump, context);
+        compile(stmt.body(), context);
+        emitLoop(loopStart, context);
+        patchJump(exitJump.offset, context);
+        popCondition(exitJump, context);
+    }
+
+    void compileCountedLoopStmt(CountedLoopStmt const& stmt, FunctionContext& context) {
+        auto const loopStart = static_cast<int>(chunk(context).code().size());
+        auto const exitJump = compileConditionJump(stmt.condition(), context);
+        popCondition(exitJump, context);
+        compile(stmt.body(), context);
+        compile(stmt.increment(), context);
+        emit(OpCode::POP, context);
+        emitLoop(loopStart, context);
+        patchJump(exitJump.offset, context);
+        popCondition(exitJump, context);
+    }
+
+    void compileFunctionStmt(FunctionStmt const& stmt, FunctionContext& context) {
+        declareVariable(stmt.name(), context);
+        markInitialized(context);
+        compileFunction(stmt, FunctionType::FUNCTION, "", context);
+        defineVariable(stmt.name(), context);
+    }
+
+    void compileReturnStmt(ReturnStmt const& stmt, FunctionContext& context) {
+        context.line = stmt.keyword().line();
+        if (stmt.value()) {
+            compile(*stmt.value(), context);
+            emit(OpCode::RETURN, context);
+        }
+        else {
+            emitReturn(context);
+        }
+    }
+
+    void compileClassStmt(ClassStmt const& stmt, FunctionContext& context) {
+        auto const isGlobal = context.scopeDepth == 0;
+        auto const classSlot = static_cast<int>(context.locals.size());
+
+        if (!isGlobal) {
+            emit(OpCode::NIL, context);
+            declareVariable(stmt.name(), context);
+            markInitialized(context);
+        }
+
+        if (auto const superclass = stmt.superclass()) {
+            namedVariable(superclass->name(), false, context);
+            emit(OpCode::INHERIT, context);
+            emitToken(superclass->name(), context);
+            beginScope(context);
+            addLocal("super", context);
+            markInitialized(context);
+        }
+
+        if (isGlobal) {
+            emit(OpCode::NIL, context);
+            emit(OpCode::DEFINE_GLOBAL, context);
+            emitToken(stmt.name(), context);
+        }
+
+        if (stmt.methods().size() > UINT8_MAX) throw CompileError{ stmt.name().line(), "Too many methods in class." };
+
+        for (auto const* method : stmt.methods()) {
+            auto const type = method->name().lexeme() == "init" ? FunctionType::INITIALIZER : FunctionType::METHOD;
+            compileFunction(*method, type, stmt.name().lexeme(), context);
+        }
+
+        emit(OpCode::CLASS, context);
+        emitToken(stmt.name(), context);
+        emitByte(static_cast<int>(stmt.methods().size()), context);
+        emitByte(stmt.superclass() ? 1 : 0, context);
+        for (auto const* method : stmt.methods()) {
+            emitToken(method->name(), context);
+        }
+
+        if (isGlobal) {
+            emit(OpCode::SET_GLOBAL, context);
+            emitToken(stmt.name(), context);
+        }
+        else {
+            emit(OpCode::SET_LOCAL, context);
+            emitByte(classSlot, context);
+        }
+        emit(OpCode::POP, context);
+
+        if (stmt.superclass()) {
+            endScope(context);
+        }
+    }
+
+    // Top-level statements also leave their result in slot zero, mirroring the
+    // value returned by the tree-walking interpreter.
+    void compileResult(Stmt const& stmt, FunctionContext& context) {
+        if (stmt.kind() == StmtKind::EXPRESSION) {
+            compile(static_cast<ExpressionStmt const&>(stmt).expression(), context);
+            emitSetResult(context);
+        }
+        else if (stmt.kind() == StmtKind::BLOCK) {
+            beginScope(context);
+            auto const& statements = static_cast<BlockStmt const&>(stmt).statements();
+            for (auto i = 0; i + 1 < static_cast<int>(statements.size()); ++i) {
+                compile(*statements[i], context);
+            }
+            if (statements.empty()) {
+                emit(OpCode::NIL, context);
+                emitSetResult(context);
+            }
+            else {
+                compileResult(*statements.back(), context);
+            }
+            endScope(context);
+        }
+        else {
+            compile(stmt, context);
+            emit(OpCode::NIL, context);
+            emitSetResult(context);
+        }
+    }
+
+    // Expressions:
+
+    void emitBinaryOperator(Token const& operatr, FunctionContext& context) {
+        switch (operatr.tokenType()) {
+        case TokenType::EQUAL_EQUAL: emit(OpCode::EQUAL, context); return;
+        case TokenType::BANG_EQUAL: emit(OpCode::NOT_EQUAL, context); return;
+        case TokenType::GREATER: emit(OpCode::GREATER, context); break;
+        case TokenType::GREATER_EQUAL: emit(OpCode::GREATER_EQUAL, context); break;
+        case TokenType::LESS: emit(OpCode::LESS, context); break;
+        case TokenType::LESS_EQUAL: emit(OpCode::LESS_EQUAL, context); break;
+        case TokenType::PLUS: emit(OpCode::ADD, context); break;
+        case TokenType::MINUS: emit(OpCode::SUBTRACT, context); break;
+        case TokenType::STAR: emit(OpCode::MULTIPLY, context); break;
+        case TokenType::SLASH: emit(OpCode::DIVIDE, context); break;
+        default:
+            throw CompileError{ operatr.line(), "Unknown binary operator '" + std::string(operatr.lexeme()) + "'." };
+        }
+        emitToken(operatr, context);
+    }
+
+    void compileBinaryExpr(BinaryExpr const& expr, FunctionContext& context) {
+        compile(expr.left(), context);
+        compile(expr.right(), context);
+        emitBinaryOperator(expr.operatr(), context);
+    }
+
+    void compileGroupingExpr(GroupingExpr const& expr, FunctionContext& context) {
+        compile(expr.expression(), context);
+    }
+
+    void compileLiteralExpr(LiteralExpr const& expr, FunctionContext& context) {
+        auto const& value = expr.value();
+        if (value.isNil()) emit(OpCode::NIL, context);
+        else if (value.isBoolean()) emit(static_cast<bool>(value) ? OpCode::TRUE : OpCode::FALSE, context);
+        else emitConstant(value, context);
+    }
+
+    void compileUnaryExpr(UnaryExpr const& expr, FunctionContext& context) {
+        compile(expr.right(), context);
+
+        auto const& operatr = expr.operatr();
+        switch (operatr.tokenType()) {
+        case TokenType::BANG:
+            emit(OpCode::NOT, context);
+            break;
+        case TokenType::MINUS:
+            emit(OpCode::NEGATE, context);
+            emitToken(operatr, context);
+            break;
+        default:
+            throw CompileError{ operatr.line(), "Unknown unary operator '" + std::string(operatr.lexeme()) + "'." };
+        }
+    }
+
+    void compileVariableExpr(VariableExpr const& expr, FunctionContext& context) {
+        namedVariable(expr.name(), false, context);
+    }
+
+    void compileAssignExpr(AssignExpr const& expr, FunctionContext& context) {
+        compile(expr.value(), context);
+        namedVariable(expr.name(), true, context);
+    }
+
+    // Adding to or subtracting from a local is a single instruction; anything
+    // else compiles like the assignment it was fused from.
+    void compileCompoundAssignExpr(CompoundAssignExpr const& expr, FunctionContext& context) {
+        auto const type = expr.operatr().tokenType();
+        auto const local = resolveLocal(expr.name().lexeme(), context);
+        if (local != -1 && (type == TokenType::PLUS || type == TokenType::MINUS)) {
+            emit(type == TokenType::PLUS ? OpCode::ADD_LOCAL : OpCode::SUBTRACT_LOCAL, context);
+            emitByte(local, context);
+            emitShortOperand(chunk(context).addConstant(Object(expr.constant())), "constants", context);
+            emitToken(expr.operatr(), context);
+            return;
+        }
+        namedVariable(expr.name(), false, context);
+        emitConstant(Object(expr.constant()), context);
+        emitBinaryOperator(expr.operatr(), context);
+        namedVariable(expr.name(), true, context);
+    }
+
+    void compileLogicalExpr(LogicalExpr const& expr, FunctionContext& context) {
+        compile(expr.left(), context);
+
+        if (expr.operatr().tokenType() == TokenType::OR) {
+            auto const elseJump = emitJump(OpCode::JUMP_IF_FALSE, context);
+            auto const endJump = emitJump(OpCode::JUMP, context);
+            patchJump(elseJump, context);
+            emit(OpCode::POP, context);
+            compile(expr.right(), context);
+            patchJump(endJump, context);
+        }
+        else { // AND
+            auto const endJump = emitJump(OpCode::JUMP_IF_FALSE, context);
+            emit(OpCode::POP, context);
+            compile(expr.right(), context);
+            patchJump(endJump, context);
+        }
+    }
+
+    void compileCallExpr(CallExpr const& expr, FunctionContext& context) {
+        compile(expr.callee(), context);
+        for (auto const* argument : expr.arguments()) {
+            compile(*argument, context);
+        }
+        emit(OpCode::CALL, context);
+        emitByte(static_cast<int>(expr.arguments().size()), context);
+        emitToken(expr.paren(), context);
+    }
+
+    void compileGetExpr(GetExpr const& expr, FunctionContext& context) {
+        compile(expr.object(), context);
+        emit(OpCode::GET_PROPERTY, context);
+        emitToken(expr.name(), context);
+    }
+
+    void compileSetExpr(SetExpr const& expr, FunctionContext& context) {
+        compile(expr.object(), context);
+        compile(expr.value(), context);
+        emit(OpCode::SET_PROPERTY, context);
+        emitToken(expr.name(), context);
+    }
+
+    void compileThisExpr(ThisExpr const& expr, FunctionContext& context) {
+        namedVariable(expr.keyword(), false, context);
+    }
+
+    void compileSuperExpr(SuperExpr const& expr, FunctionContext& context) {
+        namedVariable(Token(TokenType::THIS, "this", expr.keyword().line()), false, context);
+        namedVariable(expr.keyword(), false, context);
+        emit(OpCode::GET_SUPER, context);
+        emitToken(expr.method(), context);
+    }
+
+    // Generic compile functions:
+
+    void compile(Stmt const& stmt, FunctionContext& context) {
+        static constexpr auto compileDispatcher = Dispatcher<void, Stmt const&, FunctionContext&>::create<
+            compileExpressionStmt,
+            compileIfStmt,
+            compilePrintStmt,
+            compileWhileStmt,
+            compileVarStmt,
+            compileBlockStmt,
+            compileFunctionStmt,
+            compileReturnStmt,
+            compileClassStmt,
+            compileCountedLoopStmt
+        >("compile statement");
+
+        compileDispatcher.dispatch(stmt, context);
+    }
+
+    void compile(Expr const& expr, FunctionContext& context) {
+        static constexpr auto compileDispatcher = Dispatcher<void, Expr const&, FunctionContext&>::create<
+            compileBinaryExpr,
+            compileGroupingExpr,
+            compileLiteralExpr,
+            compileUnaryExpr,
+            compileVariableExpr,
+            compileAssignExpr,
+            compileLogicalExpr,
+            compileCallExpr,
+            compileGetExpr,
+            compileSetExpr,
+            compileThisExpr,
+            compileSuperExpr,
+            compileCompoundAssignExpr
+        >("compile expression");
+
+        compileDispatcher.dispatch(expr, context);
+    }
+}
+
+std::shared_ptr<CompiledFunction const> compile(std::vector<Stmt const*> const& statements) {
+    auto context = FunctionContext(nullptr, FunctionType::SCRIPT);
+    try {
+        for (auto const* statement : statements) {
+            compileResult(*statement, context);
+        }
+        emit(OpCode::GET_LOCAL, context);
+        emitByte(0, context);
+        emit(OpCode::RETURN, context);
+        return context.function;
+    }
+    catch (CompileError const& error) {
+        Lox::error(error.line, error.message);
+        return nullptr;
+    }
+}
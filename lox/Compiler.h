@@ -0,0 +1,9 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+class Stmt;
+struct CompiledFunction;
+
+std::shared_ptr<CompiledFunction const> compile(std::vector<Stmt const*> const& statements);
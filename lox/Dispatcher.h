@@ -1,41 +1,72 @@
 #pragma once
 
-#include <functional>
-#include <unordered_map>
-#include <typeindex>
+#include <array>
+#include <cstddef>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
+namespace detail {
+
+    template <class Function>
+    struct DispatchTarget;
+
+    template <class ReturnType, class ConcreteType, class... Args>
+    struct DispatchTarget<ReturnType(*)(ConcreteType const&, Args...)> {
+        using type = ConcreteType;
+    };
+
+}
+
+// Dispatches on the node kind tag of BaseType (see Expr::kind() and Stmt::kind()).
+// Handlers are bound at compile time, so a dispatch is a single indexed load and
+// an indirect call into a thunk that static_casts and calls the handler directly.
 template <class ReturnType, class BaseType, class... Args>
 class Dispatcher {
+    using Base = std::remove_cvref_t<BaseType>;
+    using Function = ReturnType(*)(BaseType, Args...);
+
 public:
+    template <auto... ConcreteFunctions>
+    static constexpr Dispatcher create(std::string_view name) {
+        auto dispatcher = Dispatcher(name);
+        (dispatcher.template add<ConcreteFunctions>(), ...);
+        return dispatcher;
+    }
 
-    template <class... ConcreteTypes>
-    Dispatcher(std::string const& name, std::function<ReturnType(ConcreteTypes, Args...)>&&... concreteFunctions) : mName(name)
-    {
-        (add<ConcreteTypes>(std::forward<decltype(concreteFunctions)>(concreteFunctions)), ...);
+    template <auto ConcreteFunction>
+    constexpr void add() {
+        using ConcreteType = typename detail::DispatchTarget<decltype(ConcreteFunction)>::type;
+        add<ConcreteType::nodeKind, ConcreteFunction>();
     }
 
-    template <class ConcreteType>
-    void add(std::function<ReturnType(ConcreteType, Args...)>&& concreteFunction) {
-        mDispatcher.emplace(
-            typeid(ConcreteType),
-            [=](BaseType base, Args&&... args) {
-                return concreteFunction(dynamic_cast<ConcreteType>(base), std::forward<Args>(args)...);
-            });
+    // Registers the handler for another kind than its node's own, for nodes
+    // that are switched to a specialized kind (see Expr::quicken).
+    template <auto Kind, auto ConcreteFunction>
+    constexpr void add() {
+        using ConcreteType = typename detail::DispatchTarget<decltype(ConcreteFunction)>::type;
+        static_assert(std::is_base_of_v<Base, ConcreteType>, "Dispatcher: handler must take a node derived from the base type");
+        mFunctions[static_cast<std::size_t>(Kind)] = [](BaseType base, Args... args) -> ReturnType {
+            return ConcreteFunction(static_cast<ConcreteType const&>(base), std::forward<Args>(args)...);
+        };
     }
 
     ReturnType dispatch(BaseType object, Args... args) const {
-
-        if (auto it = mDispatcher.find(typeid(object)); it != mDispatcher.end()) {
-            return it->second(object, args...);
+        auto const index = static_cast<std::size_t>(object.kind());
+        if (auto const function = mFunctions[index]) {
+            return function(object, std::forward<Args>(args)...);
         }
         else {
-            auto const errorMessage = std::string("No ") + mName + " dispatcher found for type " + typeid(object).name();
+            auto const errorMessage = "No " + std::string(mName) + " dispatcher found for node kind " + std::to_string(index);
             throw std::runtime_error(errorMessage);
         }
     }
 
 private:
-    std::string mName;
-    std::unordered_map<std::type_index, std::function<ReturnType(BaseType, Args...)>> mDispatcher;
+    constexpr explicit Dispatcher(std::string_view name) : mName(name) {}
+
+    std::string_view mName;
+    std::array<Function, Base::kindCount> mFunctions{};
 };
@@ -1,27 +1,25 @@
 #pragma once
 
 #include "Object.h"
+#include "Heap.h"
 #include <unordered_map>
 
 class Token;
 
-class Environment {
+// The global variables, looked up by name. Locals live in the frames of the
+// functions declaring them, in slots assigned by the resolver.
+class Environment : public GcObject {
 public:
-    Environment();
+    Environment() = default;
     Environment(Environment const&) = delete;
-    Environment(Environment* environment);
 
-    void define(std::string const& name, Object const& value);
+    void define(Symbol name, Object const& value);
     Object get(Token const& name) const;
-    Object getAt(int distance, std::string const& name) const;
     void assign(Token const& name, Object const& value);
-    void assignAt(int distance, Token const& name, Object const& value);
-    void remove(std::string const& name);
+    void remove(Symbol name);
 
-private:
-    Environment const& ancestor(int distance) const;
-    Environment& ancestor(int distance);
+    void trace(Tracer& tracer) const override;
 
-    std::unordered_map<std::string, Object> mValues;
-    Environment* mEnclosing;
+private:
+    std::unordered_map<Symbol, Object> mValues;
 };
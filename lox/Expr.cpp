@@ -1,50 +1,52 @@
 #include "Expr.h"
 #include <cassert>
 
-BinaryExpr::BinaryExpr(Expr const* left, Token const& operatr, Expr const* right) : mLeft(left), mOperator(operatr), mRight(right) {
+BinaryExpr::BinaryExpr(Expr const* left, Token const& operatr, Expr const* right) : Expr(nodeKind), mLeft(left), mOperator(operatr), mRight(right) {
     assert(left && "BinaryExpr ctor: left cannot be nullptr");
     assert(right && "BinaryExpr ctor: right cannot be nullptr");
 }
 
-UnaryExpr::UnaryExpr(Token const& operatr, Expr const* right) : mOperator(operatr), mRight(right) {
+UnaryExpr::UnaryExpr(Token const& operatr, Expr const* right) : Expr(nodeKind), mOperator(operatr), mRight(right) {
     assert(right && "UnaryExpr ctor: right cannot be nullptr");
 }
 
-GroupingExpr::GroupingExpr(Expr const* expression) : mExpression(expression) {
+GroupingExpr::GroupingExpr(Expr const* expression) : Expr(nodeKind), mExpression(expression) {
     assert(expression && "GroupingExpr ctor: expression cannot be nullptr");
 }
 
-LiteralExpr::LiteralExpr(Object const& value) : mValue(value) {}
+LiteralExpr::LiteralExpr(Object const& value) : Expr(nodeKind), mValue(value) {}
 
-VariableExpr::VariableExpr(Token const& name) : mName(name) {}
+VariableExpr::VariableExpr(Token const& name) : Expr(nodeKind), mName(name) {}
 
-AssignExpr::AssignExpr(Token const& name, Expr const* value) : mName(name), mValue(value) {
+AssignExpr::AssignExpr(Token const& name, Expr const* value) : Expr(nodeKind), mName(name), mValue(value) {
     assert(value && "AssignExpr ctor: value cannot be nullptr");
 }
 
-LogicalExpr::LogicalExpr(Expr const* left, Token const& operatr, Expr const* right) : mLeft(left), mOperator(operatr), mRight(right) {
+LogicalExpr::LogicalExpr(Expr const* left, Token const& operatr, Expr const* right) : Expr(nodeKind), mLeft(left), mOperator(operatr), mRight(right) {
     assert(left && "LogicalExpr ctor: left cannot be nullptr");
     assert(right && "LogicalExpr ctor: right cannot be nullptr");
 }
 
-CallExpr::CallExpr(Expr const* callee, Token const& paren, std::vector<Expr const*> const& arguments) : mCallee(callee), mParen(paren), mArguments(arguments) {
+CallExpr::CallExpr(Expr const* callee, Token const& paren, std::vector<Expr const*> const& arguments) : Expr(nodeKind), mCallee(callee), mParen(paren), mArguments(arguments) {
     assert(callee && "CallExpr ctor: callee cannot be nullptr");
     for (auto argument : arguments) {
         assert(argument && "CallExpr ctor: argument cannot be nullptr");
     }
 }
 
-GetExpr::GetExpr(Expr const* object, Token const& name) : mObject(object), mName(name) {
+GetExpr::GetExpr(Expr const* object, Token const& name) : Expr(nodeKind), mObject(object), mName(name) {
     assert(object && "GetExpr ctor: object cannot be nullptr");
 }
 
-SetExpr::SetExpr(Expr const* object, Token const& name, Expr const* value) : mObject(object), mName(name), mValue(value) {
+SetExpr::SetExpr(Expr const* object, Token const& name, Expr const* value) : Expr(nodeKind), mObject(object), mName(name), mValue(value) {
     assert(object && "SetExpr ctor: object cannot be nullptr");
     assert(value && "SetExpr ctor: value cannot be nullptr");
 }
 
-ThisExpr::ThisExpr(Token const& keyword) : mKeyword(keyword) {
+ThisExpr::ThisExpr(Token const& keyword) : Expr(nodeKind), mKeyword(keyword) {
 }
 
-SuperExpr::SuperExpr(Token const& keyword, Token const& method) : mKeyword(keyword), mMethod(method) {
+SuperExpr::SuperExpr(Token const& keyword, Token const& method) : Expr(nodeKind), mKeyword(keyword), mMethod(method) {
 }
+
+CompoundAssignExpr::CompoundAssignExpr(Token const& name, Token const& operatr, double constant) : Expr(nodeKind), mName(name), mOperator(operatr), mConstant(constant) {}
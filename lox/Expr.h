@@ -1,15 +1,41 @@
 #pragma once
 
 #include "Token.h"
+#include "InlineCache.h"
+#include "VariableSlot.h"
+#include <cstddef>
 #include <vector>
 
+enum class ExprKind {
+    BINARY, UNARY, GROUPING, LITERAL, VARIABLE, ASSIGN,
+    LOGICAL, CALL, GET, SET, THIS, SUPER,
+    // Fused kinds, which the optimizer replaces common patterns with.
+    COMPOUND_ASSIGN,
+    // Quickened kinds, which the interpreter switches nodes to at run time.
+    NUMBER_BINARY
+};
+
 class Expr {
 public:
+    static constexpr auto kindCount = static_cast<std::size_t>(ExprKind::NUMBER_BINARY) + 1;
+
+    explicit Expr(ExprKind kind) : mKind(kind) {}
     virtual ~Expr() = default;
+
+    ExprKind kind() const { return mKind; }
+    // Switches the node to a kind specialized for the operands it has seen,
+    // or back. The node stays of the same class.
+    void quicken(ExprKind kind) const { mKind = kind; }
+
+private:
+    mutable ExprKind mKind;
 };
 
+// Quickened to NUMBER_BINARY while it only sees numbers.
 class BinaryExpr : public Expr {
 public:
+    static constexpr auto nodeKind = ExprKind::BINARY;
+
     BinaryExpr(Expr const* left, Token const& operatr, Expr const* right);
 
     Expr const& left() const { return *mLeft; }
@@ -24,6 +50,8 @@ private:
 
 class UnaryExpr : public Expr {
 public:
+    static constexpr auto nodeKind = ExprKind::UNARY;
+
     UnaryExpr(Token const& operatr, Expr const* right);
     
     Token const& operatr() const { return mOperator; }
@@ -36,6 +64,8 @@ private:
 
 class GroupingExpr : public Expr {
 public:
+    static constexpr auto nodeKind = ExprKind::GROUPING;
+
     GroupingExpr(Expr const* expression);
 
     Expr const& expression() const { return *mExpression; }
@@ -46,6 +76,8 @@ private:
 
 class LiteralExpr : public Expr {
 public:
+    static constexpr auto nodeKind = ExprKind::LITERAL;
+
     LiteralExpr(Object const& value);
 
     Object const& value() const { return mValue; }
@@ -56,28 +88,40 @@ private:
 
 class VariableExpr : public Expr {
 public:
+    static constexpr auto nodeKind = ExprKind::VARIABLE;
+
     VariableExpr(Token const& name);
 
     Token const& name() const { return mName; }
+    VariableSlot const& slot() const { return mSlot; }
+    void resolveSlot(VariableSlot const& slot) const { mSlot = slot; }
 
 private:
     Token mName;
+    mutable VariableSlot mSlot;
 };
 
 class AssignExpr : public Expr {
 public:
+    static constexpr auto nodeKind = ExprKind::ASSIGN;
+
     AssignExpr(Token const& name, Expr const* value);
 
     Token const& name() const { return mName; }
     Expr const& value() const { return *mValue; }
+    VariableSlot const& slot() const { return mSlot; }
+    void resolveSlot(VariableSlot const& slot) const { mSlot = slot; }
 
 private:
     Token mName;
     Expr const* mValue;
+    mutable VariableSlot mSlot;
 };
 
 class LogicalExpr : public Expr {
 public:
+    static constexpr auto nodeKind = ExprKind::LOGICAL;
+
     LogicalExpr(Expr const* left, Token const& operatr, Expr const* right);
 
     Expr const& left() const { return *mLeft; }
@@ -92,6 +136,8 @@ private:
 
 class CallExpr : public Expr {
 public:
+    static constexpr auto nodeKind = ExprKind::CALL;
+
     CallExpr(Expr const* callee, Token const& paren, std::vector<Expr const*> const& arguments);
 
     Expr const& callee() const { return *mCallee; }
@@ -106,46 +152,89 @@ private:
 
 class GetExpr : public Expr {
 public:
+    static constexpr auto nodeKind = ExprKind::GET;
+
     GetExpr(Expr const* object, Token const& name);
     Expr const& object() const { return *mObject; }
     Token const& name() const { return mName; }
+    InlineCache const& cache() const { return mCache; }
 
 private:
     Expr const* mObject;
     Token mName;
+    InlineCache mCache;
 };
 
 class SetExpr : public Expr {
 public:
+    static constexpr auto nodeKind = ExprKind::SET;
+
     SetExpr(Expr const* object, Token const& name, Expr const* value);
     Expr const& object() const { return *mObject; }
     Token const& name() const { return mName; }
     Expr const& value() const { return *mValue; }
+    InlineCache const& cache() const { return mCache; }
 
 private:
     Expr const* mObject;
     Token mName;
     Expr const* mValue;
+    InlineCache mCache;
 };
 
 class ThisExpr : public Expr {
 public:
+    static constexpr auto nodeKind = ExprKind::THIS;
+
     ThisExpr(Token const& keyword);
 
     Token const& keyword() const { return mKeyword; }
+    VariableSlot const& slot() const { return mSlot; }
+    void resolveSlot(VariableSlot const& slot) const { mSlot = slot; }
 
 private:
     Token mKeyword;
+    mutable VariableSlot mSlot;
 };
 
 class SuperExpr : public Expr {
 public:
+    static constexpr auto nodeKind = ExprKind::SUPER;
+
     SuperExpr(Token const& keyword, Token const& method);
 
     Token const& keyword() const { return mKeyword; }
     Token const& method() const { return mMethod; }
+    VariableSlot const& slot() const { return mSlot; }
+    void resolveSlot(VariableSlot const& slot) const { mSlot = slot; }
+    // Where the instance the method is called on lives.
+    VariableSlot const& thisSlot() const { return mThisSlot; }
+    void resolveThisSlot(VariableSlot const& slot) const { mThisSlot = slot; }
 
 private:
     Token mKeyword;
     Token mMethod;
+    mutable VariableSlot mSlot;
+    mutable VariableSlot mThisSlot;
+};
+
+// x = x op k, with k a number, fused by the optimizer so that it is one node
+// rather than an assignment of an operator on a variable and a literal.
+class CompoundAssignExpr : public Expr {
+public:
+    static constexpr auto nodeKind = ExprKind::COMPOUND_ASSIGN;
+
+    CompoundAssignExpr(Token const& name, Token const& operatr, double constant);
+
+    Token const& name() const { return mName; }
+    Token const& operatr() const { return mOperator; }
+    double constant() const { return mConstant; }
+    VariableSlot const& slot() const { return mSlot; }
+    void resolveSlot(VariableSlot const& slot) const { mSlot = slot; }
+
+private:
+    Token mName;
+    Token mOperator;
+    double mConstant;
+    mutable VariableSlot mSlot;
 };
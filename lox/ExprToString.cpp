@@ -6,7 +6,7 @@
 namespace {
 
     std::string binaryExprToString(BinaryExpr const& expr) {
-        return "(" + expr.operatr().lexeme() + " " + toString(expr.left()) + " " + toString(expr.right()) + ")";
+        return "(" + std::string(expr.operatr().lexeme()) + " " + toString(expr.left()) + " " + toString(expr.right()) + ")";
     }
 
     std::string groupingExprToString(GroupingExpr const& expr) {
@@ -14,26 +14,79 @@ namespace {
     }
 
     std::string literalExprToString(LiteralExpr const& expr) {
+        if (expr.value().isString()) return "\"" + expr.value().toString() + "\"";
+        if (expr.value().isNil()) return "nil";
         return expr.value().toString();
     }
 
     std::string unaryExprToString(UnaryExpr const& expr) {
-        return "(" + expr.operatr().lexeme() + " " + toString(expr.right()) + ")";
+        return "(" + std::string(expr.operatr().lexeme()) + " " + toString(expr.right()) + ")";
     }
 
-}
+    std::string variableExprToString(VariableExpr const& expr) {
+        return std::string(expr.name().lexeme());
+    }
+
+    std::string assignExprToString(AssignExpr const& expr) {
+        return "(= " + std::string(expr.name().lexeme()) + " " + toString(expr.value()) + ")";
+    }
+
+    std::string logicalExprToString(LogicalExpr const& expr) {
+        return "(" + std::string(expr.operatr().lexeme()) + " " + toString(expr.left()) + " " + toString(expr.right()) + ")";
+    }
+
+    std::string callExprToString(CallExpr const& expr) {
+        auto result = "(call " + toString(expr.callee());
+        for (auto const* argument : expr.arguments()) {
+            result += " " + toString(*argument);
+        }
+        return result + ")";
+    }
+
+    std::string getExprToString(GetExpr const& expr) {
+        return "(. " + toString(expr.object()) + " " + std::string(expr.name().lexeme()) + ")";
+    }
 
-template <typename T>
-using DispatcherFuncT = std::function<std::string(T const&)>;
+    std::string setExprToString(SetExpr const& expr) {
+        return "(= (. " + toString(expr.object()) + " " + std::string(expr.name().lexeme()) + ") " + toString(expr.value()) + ")";
+    }
+
+    std::string thisExprToString(ThisExpr const&) {
+        return "this";
+    }
+
+    std::string superExprToString(SuperExpr const& expr) {
+        return "(super " + std::string(expr.method().lexeme()) + ")";
+    }
+
+    std::string compoundAssignExprToString(CompoundAssignExpr const& expr) {
+        return "(" + std::string(expr.operatr().lexeme()) + "= " + std::string(expr.name().lexeme()) + " " + Object(expr.constant()).toString() + ")";
+    }
+
+}
 
 std::string toString(Expr const& expr) {
 
-    static auto const dispatcher = Dispatcher<std::string, Expr const&>("binary expression to string",
-        DispatcherFuncT<BinaryExpr>(binaryExprToString),
-        DispatcherFuncT<GroupingExpr>(groupingExprToString),
-        DispatcherFuncT<LiteralExpr>(literalExprToString),
-        DispatcherFuncT<UnaryExpr>(unaryExprToString)
-    );
+    // Trees that have run may have quickened nodes.
+    static constexpr auto dispatcher = [] {
+        auto dispatcher = Dispatcher<std::string, Expr const&>::create<
+            binaryExprToString,
+            groupingExprToString,
+            literalExprToString,
+            unaryExprToString,
+            variableExprToString,
+            assignExprToString,
+            logicalExprToString,
+            callExprToString,
+            getExprToString,
+            setExprToString,
+            thisExprToString,
+            superExprToString,
+            compoundAssignExprToString
+        >("expression to string");
+        dispatcher.add<ExprKind::NUMBER_BINARY, binaryExprToString>();
+        return dispatcher;
+    }();
 
     return dispatcher.dispatch(expr);
 }
@@ -0,0 +1,68 @@
+#include "Heap.h"
+#include "Object.h"
+#include <algorithm>
+
+void Tracer::mark(GcObject const* object) {
+    // Objects not owned by the heap are traced through their root registration.
+    if (!object || object->mSize == 0 || object->mMarked) return;
+    object->mMarked = true;
+    mGray.push_back(object);
+}
+
+void Tracer::mark(Object const& object) {
+    object.trace(*this);
+}
+
+void Tracer::mark(std::vector<Object> const& objects) {
+    for (auto const& object : objects) {
+        object.trace(*this);
+    }
+}
+
+Heap::~Heap() {
+    while (mObjects) {
+        delete std::exchange(mObjects, mObjects->mNext);
+    }
+}
+
+void Heap::collect() {
+    auto tracer = Tracer();
+    for (auto const& root : mRoots) {
+        if (auto const object = std::get_if<GcObject const*>(&root)) {
+            if ((*object)->mSize == 0) (*object)->trace(tracer);
+            else tracer.mark(*object);
+        }
+        else if (auto const object = std::get_if<Object const*>(&root)) {
+            tracer.mark(**object);
+        }
+        else {
+            tracer.mark(*std::get<std::vector<Object> const*>(root));
+        }
+    }
+
+    while (!tracer.mGray.empty()) {
+        auto const object = tracer.mGray.back();
+        tracer.mGray.pop_back();
+        object->trace(tracer);
+    }
+
+    sweep();
+    ++mStats.collections;
+    mThreshold = std::max(initialThreshold, mStats.liveBytes() * 2);
+}
+
+void Heap::sweep() {
+    auto link = &mObjects;
+    while (auto const object = *link) {
+        if (object->mMarked) {
+            object->mMarked = false;
+            link = &object->mNext;
+        }
+        else {
+            *link = object->mNext;
+            ++mStats.objectsFreed;
+            mStats.bytesFreed += object->mSize;
+            delete object;
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <variant>
+#include <vector>
+
+class Object;
+class Tracer;
+
+// Base class of everything the collector manages: environments, instance
+// fields, method tables and closure state. Objects created with
+// Heap::allocate are owned by the heap; other instances (like Lox::globals)
+// are never freed and only take part in tracing when registered as roots.
+class GcObject {
+public:
+    GcObject() = default;
+    GcObject(GcObject const&) {}
+    GcObject& operator=(GcObject const&) { return *this; }
+    virtual ~GcObject() = default;
+
+    virtual void trace(Tracer& tracer) const = 0;
+
+private:
+    friend class Heap;
+    friend class Tracer;
+
+    GcObject* mNext = nullptr;
+    std::size_t mSize = 0; // 0 when not owned by the heap
+    mutable bool mMarked = false;
+};
+
+class Tracer {
+public:
+    void mark(GcObject const* object);
+    void mark(Object const& object);
+    void mark(std::vector<Object> const& objects);
+
+private:
+    friend class Heap;
+    std::vector<GcObject const*> mGray;
+};
+
+struct GcStats {
+    std::size_t collections = 0;
+    std::size_t objectsAllocated = 0;
+    std::size_t objectsFreed = 0;
+    std::size_t bytesAllocated = 0;
+    std::size_t bytesFreed = 0;
+
+    std::size_t liveObjects() const { return objectsAllocated - objectsFreed; }
+    std::size_t liveBytes() const { return bytesAllocated - bytesFreed; }
+};
+
+// Mark-sweep collector. Allocation never collects by itself; the interpreter
+// and the VM call safepoint() at statement boundaries and loop back-edges,
+// where every live value is reachable from a registered root.
+class Heap {
+    using RootRef = std::variant<GcObject const*, Object const*, std::vector<Object> const*>;
+
+public:
+    // Registers a root for the lifetime of the guard. Guards must be destroyed
+    // in reverse order of creation, which scoping them to locals guarantees.
+    class [[nodiscard]] Root {
+    public:
+        Root(Root const&) = delete;
+        Root& operator=(Root const&) = delete;
+        ~Root() { mHeap.mRoots.pop_back(); }
+
+    private:
+        friend class Heap;
+        Root(Heap& heap, RootRef root) : mHeap(heap) { mHeap.mRoots.push_back(root); }
+        Heap& mHeap;
+    };
+
+    static constexpr std::size_t initialThreshold = 1024 * 1024;
+
+    Heap() = default;
+    Heap(Heap const&) = delete;
+    Heap& operator=(Heap const&) = delete;
+    ~Heap();
+
+    template <class T, class... Args>
+    T* allocate(Args&&... args) {
+        auto const object = new T(std::forward<Args>(args)...);
+        object->mSize = sizeof(T);
+        object->mNext = mObjects;
+        mObjects = object;
+        ++mStats.objectsAllocated;
+        mStats.bytesAllocated += sizeof(T);
+        return object;
+    }
+
+    Root root(GcObject const& object) { return Root(*this, &object); }
+    Root root(Object const& object) { return Root(*this, &object); }
+    Root root(std::vector<Object> const& objects) { return Root(*this, &objects); }
+
+    void safepoint() {
+#ifdef LOX_STRESS_GC
+        collect();
+#else
+        if (mStats.liveBytes() >= mThreshold) collect();
+#endif
+    }
+    void collect();
+
+    GcStats const& stats() const { return mStats; }
+
+private:
+    void sweep();
+
+    GcObject* mObjects = nullptr;
+    std::vector<RootRef> mRoots;
+    std::size_t mThreshold = initialThreshold;
+    GcStats mStats;
+};
@@ -0,0 +1,14 @@
+#include "InlineCache.h"
+
+InlineCacheStats InlineCache::stats;
+
+void InlineCache::insert(Entry const& entry) const {
+    if (auto const generation = LoxClass::generation(); mGeneration != generation) {
+        mSize = 0;
+        mGeneration = generation;
+    }
+
+    if (mSize != capacity) {
+        mEntries[mSize++] = entry;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Object.h"
+#include <array>
+#include <cstddef>
+
+class Shape;
+
+struct InlineCacheStats {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+};
+
+// Remembers the result of a lookup at one call site, so that a site which
+// keeps seeing the same receiver layout resolves it with a pointer compare.
+// Property accesses are keyed on the instance's shape, which also identifies
+// its class. Up to `capacity` keys are remembered for polymorphic sites;
+// beyond that the site is megamorphic and further keys are looked up every
+// time.
+//
+// The cache does not keep its keys alive. Shapes live as long as their class,
+// so the cache is emptied whenever a class has been freed, since the freed
+// class's identity and shapes may be reused.
+class InlineCache {
+public:
+    static constexpr std::size_t capacity = 4;
+
+    struct Entry {
+        void const* key = nullptr;
+        int slot = -1;                       // field slot, or -1 for a method
+        Object method = {};                  // method found when there is no such field
+        Shape const* transition = nullptr;   // shape after adding the field, for stores
+    };
+
+    Entry const* find(void const* key) const {
+        if (mGeneration == LoxClass::generation()) {
+            for (std::size_t i = 0; i != mSize; ++i) {
+                if (mEntries[i].key == key) {
+                    ++stats.hits;
+                    return &mEntries[i];
+                }
+            }
+        }
+        ++stats.misses;
+        return nullptr;
+    }
+
+    void insert(Entry const& entry) const;
+
+    static InlineCacheStats stats;
+
+private:
+    mutable std::array<Entry, capacity> mEntries;
+    mutable std::size_t mSize = 0;
+    mutable std::size_t mGeneration = 0;
+};
@@ -19,10 +19,140 @@
 
 namespace {
 
-    struct Return {
-        Object object;
+    // Outcome of executing a statement. A return statement hands back a
+    // returning completion that enclosing blocks, loops and ifs pass on
+    // unchanged until the function call executing them picks up its value.
+    // Otherwise the value is that of the last expression statement, which the
+    // REPL prints.
+    struct Completion {
+        Object value;
+        bool returning = false;
     };
 
+    // A local captured by closures, shared by the frame declaring it and the
+    // closures.
+    struct Cell : GcObject {
+        explicit Cell(Object const& value) : value(value) {}
+        void trace(Tracer& tracer) const override { tracer.mark(value); }
+
+        Object value;
+    };
+
+    // The cells a function captured when it was declared, in the order of its
+    // FrameLayout::captures.
+    struct Closure : GcObject {
+        void trace(Tracer& tracer) const override {
+            for (auto const* upvalue : upvalues) {
+                tracer.mark(upvalue);
+            }
+        }
+
+        std::vector<Cell*> upvalues;
+    };
+
+    // The locals of one call, laid out by the resolver: its window onto the
+    // call stack, and the cells the function captured when it was declared.
+    struct Frame {
+        Object* slots;
+        Cell** cells;
+        Closure const* closure;
+    };
+
+    // Storage for the frames of all active calls, allocated once. A call takes
+    // the slots its layout asks for on top of its caller's and hands them back
+    // cleared when it returns, so everything above the top is nil. The top
+    // level's frame sits at the bottom and grows as its blocks declare locals.
+    //
+    // Not owned by the heap; interpret() registers it as a root.
+    class CallStack : public GcObject {
+    public:
+        static constexpr std::size_t slotCapacity = 64 * 1024;
+        static constexpr std::size_t cellCapacity = 16 * 1024;
+
+        CallStack() : mSlots(slotCapacity), mCells(cellCapacity) {}
+
+        int depth() const { return mDepth; }
+
+        Frame topLevel() {
+            assert(mDepth == 0);
+            return { mSlots.data(), mCells.data(), nullptr };
+        }
+
+        // The frame for a call of function. Running out of room is a stack
+        // overflow like exceeding Lox::maxCallDepth, which calls check first.
+        Frame push(FrameLayout const& layout, Closure const* closure, Token const& function) {
+            if (slotCapacity - mSlotTop < static_cast<std::size_t>(layout.slotCount) || cellCapacity - mCellTop < static_cast<std::size_t>(layout.cellCount)) {
+                throw RuntimeError{ function, "Stack overflow." };
+            }
+            auto const frame = Frame{ mSlots.data() + mSlotTop, mCells.data() + mCellTop, closure };
+            mSlotTop += layout.slotCount;
+            mCellTop += layout.cellCount;
+            ++mDepth;
+            return frame;
+        }
+
+        void pop(FrameLayout const& layout) {
+            mSlotTop -= layout.slotCount;
+            mCellTop -= layout.cellCount;
+            --mDepth;
+            std::fill_n(mSlots.begin() + mSlotTop, layout.slotCount, Object());
+            std::fill_n(mCells.begin() + mCellTop, layout.cellCount, nullptr);
+        }
+
+        // Room above the top for the arguments of a call, so that they are
+        // evaluated in place and stay rooted until the call returns.
+        std::span<Object> pushArguments(std::size_t count, Token const& paren) {
+            if (slotCapacity - mSlotTop < count) {
+                throw RuntimeError{ paren, "Stack overflow." };
+            }
+            auto const arguments = std::span(mSlots).subspan(mSlotTop, count);
+            mSlotTop += count;
+            return arguments;
+        }
+
+        void popArguments(std::size_t count) {
+            mSlotTop -= count;
+            std::fill_n(mSlots.begin() + mSlotTop, count, Object());
+        }
+
+        // Makes sure a slot being defined is below the top. Only the top
+        // level's frame is not sized up front and ever needs to grow.
+        void claim(Object const* slot) {
+            mSlotTop = std::max(mSlotTop, static_cast<std::size_t>(slot - mSlots.data()) + 1);
+            assert(mSlotTop <= slotCapacity);
+        }
+        void claim(Cell* const* cell) {
+            mCellTop = std::max(mCellTop, static_cast<std::size_t>(cell - mCells.data()) + 1);
+            assert(mCellTop <= cellCapacity);
+        }
+
+        // Drops every frame, after a runtime error or once the top level is done.
+        void reset() {
+            std::fill_n(mSlots.begin(), mSlotTop, Object());
+            std::fill_n(mCells.begin(), mCellTop, nullptr);
+            mSlotTop = mCellTop = 0;
+            mDepth = 0;
+        }
+
+        void trace(Tracer& tracer) const override {
+            for (std::size_t i = 0; i != mSlotTop; ++i) {
+                tracer.mark(mSlots[i]);
+            }
+            for (std::size_t i = 0; i != mCellTop; ++i) {
+                tracer.mark(mCells[i]);
+            }
+        }
+
+    private:
+        std::vector<Object> mSlots;
+        std::vector<Cell*> mCells;
+        std::size_t mSlotTop = 0;
+        std::size_t mCellTop = 0;
+        int mDepth = 0;
+    };
+
+    CallStack callStack;
+
     // Utility functions used in the concrete execute/evaluate functions
 
     bool isTruthy(Object const& object) {
@@ -39,59 +169,120 @@ namespace {
         if (!left.isDouble() || !right.isDouble()) throw RuntimeError{token, "Operands must be numbers."};
     }
 
-    Object lookupVariable(Token const& name, Expr const& expr, Environment const& environment) {
-        
-        if (auto const it = Lox::locals.find(&expr); it != Lox::locals.end()) {
-            return environment.getAt(it->second, name.lexeme());
-        }
-        else {
+    Object lookupVariable(Token const& name, VariableSlot const& slot, Frame const& frame) {
+        switch (slot.kind) {
+        case VariableSlot::Kind::LOCAL:
+            return frame.slots[slot.index];
+        case VariableSlot::Kind::CELL:
+            return frame.cells[slot.index]->value;
+        case VariableSlot::Kind::UPVALUE:
+            return frame.closure->upvalues[slot.index]->value;
+        default:
             return Lox::globals.get(name);
         }
     }
 
+    void assignVariable(Token const& name, VariableSlot const& slot, Object const& value, Frame& frame) {
+        switch (slot.kind) {
+        case VariableSlot::Kind::LOCAL:
+            frame.slots[slot.index] = value;
+            break;
+        case VariableSlot::Kind::CELL:
+            frame.cells[slot.index]->value = value;
+            break;
+        case VariableSlot::Kind::UPVALUE:
+            frame.closure->upvalues[slot.index]->value = value;
+            break;
+        default:
+            Lox::globals.assign(name, value);
+        }
+    }
+
+    // Declarations resolved to a slot live in the frame, captured ones in a
+    // new cell each time the declaration runs, unresolved (global) ones are
+    // looked up by name.
+    void defineVariable(VariableSlot const& slot, Token const& name, Object const& value, Frame& frame) {
+        switch (slot.kind) {
+        case VariableSlot::Kind::LOCAL:
+            callStack.claim(frame.slots + slot.index);
+            frame.slots[slot.index] = value;
+            break;
+        case VariableSlot::Kind::CELL:
+            callStack.claim(frame.cells + slot.index);
+            frame.cells[slot.index] = Lox::heap.allocate<Cell>(value);
+            break;
+        default:
+            assert(slot.isGlobal());
+            Lox::globals.define(name.symbol(), value);
+        }
+    }
+
     template <class T>
-    auto loxCall(Object const& callee, std::vector<Object> const& arguments, Token const& paren) {
+    auto loxCall(Object const& callee, LoxCallable::ArgsType arguments, Token const& paren) {
         auto const& function = static_cast<T>(callee);
 
-        if (function.arity() != arguments.size()) {
+        if (static_cast<std::size_t>(function.arity()) != arguments.size()) {
             throw RuntimeError{ paren, "Expected " + std::to_string(function.arity()) + " arguments but got " + std::to_string(arguments.size()) + "." };
         }
 
         return function(arguments);
     }
 
-    Object executeBlockStmt(BlockStmt const& stmt, Environment& environment);
+    Completion executeBlockStmt(BlockStmt const& stmt, Frame& frame);
+
+    // Creates the function a declaration stands for, capturing the cells its
+    // layout asks for from the declaring frame. Calls run in a frame of their
+    // own; only functions that capture something need heap state.
+    auto loxCallableFromFunctionStmt(FunctionStmt const& stmt, Frame& frame, std::string_view className = {}) {
+        auto const isMethod = !className.empty();
+        auto const isInitializer = isMethod && stmt.name().lexeme() == "init";
+        auto const& captures = stmt.layout().captures;
+        auto const closure = captures.empty() ? nullptr : Lox::heap.allocate<Closure>();
+        for (auto const& capture : captures) {
+            closure->upvalues.push_back(capture.fromCell ? frame.cells[capture.index] : frame.closure->upvalues[capture.index]);
+        }
 
-    auto loxCallableFromFunctionStmt(FunctionStmt const& stmt, Environment& environment, std::string const& className = "") {
-        auto const isInitializer = !className.empty() && stmt.name().lexeme() == "init";
-        auto executeFun = [&stmt,isInitializer](Environment* closure, std::vector<Object> const& arguments) {
-            auto environment = new Environment(closure);
-            for (auto const& [param, arg] : std::views::zip(stmt.parameters(), arguments)) {
-                environment->define(param.lexeme(), arg);
-            }
-            try {
-                executeBlockStmt(stmt.body(), *environment);
-            }
-            catch (Return const& ret) {
-                return isInitializer ? closure->getAt(0, "this") : ret.object;
+        auto executeFun = [&stmt, closure, isMethod, isInitializer](Object const& receiver, LoxCallable::ArgsType arguments) {
+            auto const& layout = stmt.layout();
+            auto frame = callStack.push(layout, closure, stmt.name());
+            // Methods find 'this' in the first slot.
+            if (isMethod) frame.slots[0] = receiver;
+            std::ranges::copy(arguments, frame.slots + (isMethod ? 1 : 0));
+            for (auto const& parameter : layout.capturedParameters) {
+                frame.cells[parameter.cell] = Lox::heap.allocate<Cell>(frame.slots[parameter.slot]);
             }
-            return isInitializer ? closure->getAt(0, "this") : Object();
+            auto const completion = executeBlockStmt(stmt.body(), frame);
+            callStack.pop(layout);
+            if (isInitializer) return receiver;
+            return completion.returning ? completion.value : Object();
         };
 
-        auto const functionName = className.empty() ? stmt.name().lexeme() : className + "::" + stmt.name().lexeme();
-        return LoxCallable(executeFun, &environment, static_cast<int>(stmt.parameters().size()), functionName);
+        auto const functionName = isMethod ? std::string(className) + "::" + std::string(stmt.name().lexeme()) : std::string(stmt.name().lexeme());
+        return LoxCallable(executeFun, static_cast<int>(stmt.parameters().size()), functionName, closure);
     }
 
     // Forward declaration of generic execute/evaluate:
-    Object execute(Stmt const& statement, Environment& environment);
-    Object evaluate(Expr const& expr, Environment& environment);
+    Completion execute(Stmt const& statement, Frame& frame);
+    Object evaluate(Expr const& expr, Frame& frame);
 
-    // Evaluate functions of concrete expressions:
-    Object evaluateBinaryExpr(BinaryExpr const& expr, Environment& environment) {
-        auto const left = evaluate(expr.left(), environment);
-        auto const right = evaluate(expr.right(), environment);
-        auto const& operatr = expr.operatr();
+    Object numberOperation(Token const& operatr, double left, double right) {
+        switch (operatr.tokenType()) {
+        case TokenType::MINUS: return left - right;
+        case TokenType::PLUS: return left + right;
+        case TokenType::SLASH: return left / right;
+        case TokenType::STAR: return left * right;
+        case TokenType::BANG_EQUAL: return left != right;
+        case TokenType::EQUAL_EQUAL: return left == right;
+        case TokenType::GREATER: return left > right;
+        case TokenType::GREATER_EQUAL: return left >= right;
+        case TokenType::LESS: return left < right;
+        case TokenType::LESS_EQUAL: return left <= right;
+        default:
+            throw RuntimeError{ operatr, "Sorry I cannot do this!" };
+        }
+    }
 
+    Object binaryOperation(Token const& operatr, Object const& left, Object const& right) {
         switch (operatr.tokenType()) {
         case TokenType::MINUS:
             checkNumberOperands(operatr, left, right);
@@ -128,17 +319,45 @@ namespace {
             checkNumberOperands(operatr, left, right);
             return static_cast<double>(left) <= static_cast<double>(right);
         default:
-            throw RuntimeError{ expr.operatr(), "Sorry I cannot do this!" };
+            throw RuntimeError{ operatr, "Sorry I cannot do this!" };
+        }
+    }
+
+    // Evaluate functions of concrete expressions:
+    Object evaluateBinaryExpr(BinaryExpr const& expr, Frame& frame) {
+        auto const left = evaluate(expr.left(), frame);
+        auto const leftRoot = Lox::heap.root(left);
+        auto const right = evaluate(expr.right(), frame);
+        if (left.isDouble() && right.isDouble()) {
+            expr.quicken(ExprKind::NUMBER_BINARY);
+            return numberOperation(expr.operatr(), left.asDouble(), right.asDouble());
+        }
+        return binaryOperation(expr.operatr(), left, right);
+    }
+    // A binary expression that has only seen numbers. A number needs no root,
+    // and once both operands are known to be numbers they are used unchecked.
+    // Anything else switches the node back.
+    Object evaluateNumberBinaryExpr(BinaryExpr const& expr, Frame& frame) {
+        auto const left = evaluate(expr.left(), frame);
+        if (left.isDouble()) {
+            auto const right = evaluate(expr.right(), frame);
+            if (right.isDouble()) return numberOperation(expr.operatr(), left.asDouble(), right.asDouble());
+            expr.quicken(ExprKind::BINARY);
+            return binaryOperation(expr.operatr(), left, right);
         }
+        expr.quicken(ExprKind::BINARY);
+        auto const leftRoot = Lox::heap.root(left);
+        auto const right = evaluate(expr.right(), frame);
+        return binaryOperation(expr.operatr(), left, right);
     }
-    Object evaluateGroupingExpr(GroupingExpr const& expr, Environment& environment) {
-        return evaluate(expr.expression(), environment);
+    Object evaluateGroupingExpr(GroupingExpr const& expr, Frame& frame) {
+        return evaluate(expr.expression(), frame);
     }
-    Object evaluateLiteralExpr(LiteralExpr const& expr, Environment& environment) {
+    Object evaluateLiteralExpr(LiteralExpr const& expr, Frame&) {
         return expr.value();
     }
-    Object evaluateUnaryExpr(UnaryExpr const& expr, Environment& environment) {
-        auto const right = evaluate(expr.right(), environment);
+    Object evaluateUnaryExpr(UnaryExpr const& expr, Frame& frame) {
+        auto const right = evaluate(expr.right(), frame);
         auto const& operatr = expr.operatr();
 
         switch (operatr.tokenType()) {
@@ -146,32 +365,33 @@ namespace {
             return !isTruthy(right);
         case TokenType::MINUS:
             checkNumberOperand(operatr, right);
-            return -static_cast<double>(right);
-            break;
+            return -right.asDouble();
         default:
             throw std::logic_error("what happen?");
         }
     }
 
-    Object evaluateVariableExpr(VariableExpr const& expr, Environment& environment) {
-        return lookupVariable(expr.name(), expr, environment);
+    Object evaluateVariableExpr(VariableExpr const& expr, Frame& frame) {
+        return lookupVariable(expr.name(), expr.slot(), frame);
     }
 
-    Object evaluateAssignExpr(AssignExpr const& expr, Environment& environment) {
-        auto const value = evaluate(expr.value(), environment);
-        
-        if (auto const it = Lox::locals.find(&expr); it != Lox::locals.end()) {
-            environment.assignAt(it->second, expr.name(), value);
-        }
-        else {
-            Lox::globals.assign(expr.name(), value);
-        }
-
+    Object evaluateAssignExpr(AssignExpr const& expr, Frame& frame) {
+        auto const value = evaluate(expr.value(), frame);
+        assignVariable(expr.name(), expr.slot(), value, frame);
         return value;
     }
+
+    Object evaluateCompoundAssignExpr(CompoundAssignExpr const& expr, Frame& frame) {
+        auto const value = lookupVariable(expr.name(), expr.slot(), frame);
+        auto const result = value.isDouble()
+            ? numberOperation(expr.operatr(), value.asDouble(), expr.constant())
+            : binaryOperation(expr.operatr(), value, Object(expr.constant()));
+        assignVariable(expr.name(), expr.slot(), result, frame);
+        return result;
+    }
     
-    Object evaluateLogicalExpr(LogicalExpr const& expr, Environment& environment) {
-        auto const lhs = evaluate(expr.left(), environment);
+    Object evaluateLogicalExpr(LogicalExpr const& expr, Frame& frame) {
+        auto const lhs = evaluate(expr.left(), frame);
 
         if (expr.operatr().tokenType() == TokenType::OR) {
             if (isTruthy(lhs)) return lhs;
@@ -180,190 +400,274 @@ namespace {
             if (!isTruthy(lhs)) return lhs;
         }
 
-        return evaluate(expr.right(), environment);
+        return evaluate(expr.right(), frame);
+    }
+
+    // The method a super expression refers to and the instance to call it on.
+    std::pair<Object, Object> findSuperMethod(SuperExpr const& expr, Frame& frame) {
+        auto const super = lookupVariable(expr.keyword(), expr.slot(), frame);
+        assert(super.isLoxClass());
+        auto const method = static_cast<LoxClass>(super).findMethod(expr.method().symbol());
+        return { method, lookupVariable(expr.keyword(), expr.thisSlot(), frame) };
     }
 
-    Object evaluateCallExpr(CallExpr const& expr, Environment& environment) {
-        auto const callee = evaluate(expr.callee(), environment);
-        auto arguments = std::vector<Object>();
-        auto const proj = [&](Expr const* expr) { return evaluate(*expr, environment); };
-        std::ranges::transform(expr.arguments(), std::back_inserter(arguments), proj);
+    Object evaluateCallExpr(CallExpr const& expr, Frame& frame) {
+        // For obj.method(...) and super.method(...) the method is called with
+        // `this` passed directly, rather than bound first and then called.
+        auto callee = Object();
+        auto receiver = Object();
+        if (expr.callee().kind() == ExprKind::GET) {
+            auto const& get = static_cast<GetExpr const&>(expr.callee());
+            receiver = evaluate(get.object(), frame);
+            if (!receiver.isLoxInstance()) throw RuntimeError{ get.name(), "Only instances have properties." };
+            auto const instance = static_cast<LoxInstance>(receiver);
+            if (auto const method = instance.method(get.name(), get.cache())) {
+                callee = *method;
+            }
+            else {
+                callee = instance.get(get.name(), get.cache());
+                receiver = Object();
+            }
+        }
+        else if (expr.callee().kind() == ExprKind::SUPER) {
+            std::tie(callee, receiver) = findSuperMethod(static_cast<SuperExpr const&>(expr.callee()), frame);
+            if (!callee.isLoxCallable()) receiver = Object();
+        }
+        else {
+            callee = evaluate(expr.callee(), frame);
+        }
 
-        if (callee.isLoxCallable()) {
-            return loxCall<LoxCallable>(callee, arguments, expr.paren());
+        auto const calleeRoot = Lox::heap.root(callee);
+        auto const receiverRoot = Lox::heap.root(receiver);
+        auto const argumentCount = expr.arguments().size();
+        auto const arguments = callStack.pushArguments(argumentCount, expr.paren());
+        for (std::size_t i = 0; i != argumentCount; ++i) {
+            arguments[i] = evaluate(*expr.arguments()[i], frame);
+        }
+
+        // Every call takes native stack as well, so deep recursion is stopped
+        // before it can run out of that.
+        if (callStack.depth() >= Lox::maxCallDepth || Lox::nativeStackExhausted()) {
+            throw RuntimeError{ expr.paren(), "Stack overflow." };
+        }
+        auto result = Object();
+        if (receiver.isLoxInstance()) {
+            auto const method = static_cast<LoxCallable>(callee);
+            if (static_cast<std::size_t>(method.arity()) != argumentCount) {
+                throw RuntimeError{ expr.paren(), "Expected " + std::to_string(method.arity()) + " arguments but got " + std::to_string(argumentCount) + "." };
+            }
+            result = method.call(static_cast<LoxInstance>(receiver), arguments);
+        }
+        else if (callee.isLoxCallable()) {
+            result = loxCall<LoxCallable>(callee, arguments, expr.paren());
         }
         else if(callee.isLoxClass()) {
-            return loxCall<LoxClass>(callee, arguments, expr.paren());
+            result = loxCall<LoxClass>(callee, arguments, expr.paren());
         }
         else {
             throw RuntimeError{ expr.paren(), "Can only call functions and classes." };
         }
+        // A runtime error leaves the arguments to CallStack::reset().
+        callStack.popArguments(argumentCount);
+        return result;
     }
-    Object evaluateGetExpr(GetExpr const& expr, Environment& environment) {
-        auto const object = evaluate(expr.object(), environment);
+    Object evaluateGetExpr(GetExpr const& expr, Frame& frame) {
+        auto const object = evaluate(expr.object(), frame);
         if (object.isLoxInstance()) {
-            return static_cast<LoxInstance>(object).get(expr.name());
+            return static_cast<LoxInstance>(object).get(expr.name(), expr.cache());
         }
 
         throw RuntimeError{ expr.name(), "Only instances have properties." };
     }
-    Object evaluateSetExpr(SetExpr const& expr, Environment& environment) {
-        auto const object = evaluate(expr.object(), environment);
+    Object evaluateSetExpr(SetExpr const& expr, Frame& frame) {
+        auto const object = evaluate(expr.object(), frame);
         if (!object.isLoxInstance()) {
             throw RuntimeError{ expr.name(), "Only instances have properties." };
         }
 
-        auto const value = evaluate(expr.value(), environment);
-        static_cast<LoxInstance>(object).set(expr.name(), value);
+        auto const objectRoot = Lox::heap.root(object);
+        auto const value = evaluate(expr.value(), frame);
+        static_cast<LoxInstance>(object).set(expr.name(), value, expr.cache());
         return value;
     }
-    Object evaluateThisExpr(ThisExpr const& expr, Environment& environment) {
-        return lookupVariable(expr.keyword(), expr, environment);
+    Object evaluateThisExpr(ThisExpr const& expr, Frame& frame) {
+        return lookupVariable(expr.keyword(), expr.slot(), frame);
     }
-    Object evaluateSuperExpr(SuperExpr const& expr, Environment& environment) {
-        auto const distance = Lox::locals.at(&expr) + 1;
-        auto const super = environment.getAt(distance, expr.keyword().lexeme());
-        assert(super.isLoxClass());
-        return static_cast<LoxClass>(super).findMethod(expr.method().lexeme());
+    Object evaluateSuperExpr(SuperExpr const& expr, Frame& frame) {
+        auto const [method, instance] = findSuperMethod(expr, frame);
+        if (!method.isLoxCallable()) return method;
+        return static_cast<LoxCallable>(method).bind(static_cast<LoxInstance>(instance));
     }
 
     // Execute functions of concrete statements:
 
-    Object executeExpressionStmt(ExpressionStmt const& stmt, Environment& environment) {
-        return evaluate(stmt.expression(), environment);
+    Completion executeExpressionStmt(ExpressionStmt const& stmt, Frame& frame) {
+        return { evaluate(stmt.expression(), frame) };
     }
 
-    Object executeIfStmt(IfStmt const& stmt, Environment& environment) {
-        auto const condition = evaluate(stmt.condition(), environment);
-        if (condition)
-        {
-            execute(stmt.thenBranch(), environment);
-        }
-        else if (auto const elseBranch = stmt.elseBranch()) {
-            execute(*elseBranch, environment);
+    Completion executeIfStmt(IfStmt const& stmt, Frame& frame) {
+        auto const condition = evaluate(stmt.condition(), frame);
+        auto const branch = isTruthy(condition) ? &stmt.thenBranch() : stmt.elseBranch();
+        if (branch) {
+            if (auto completion = execute(*branch, frame); completion.returning) return completion;
         }
         return {};
     }
 
-    Object executePrintStmt(PrintStmt const& stmt, Environment& environment) {
-        auto const value = evaluate(stmt.expression(), environment);
+    Completion executePrintStmt(PrintStmt const& stmt, Frame& frame) {
+        auto const value = evaluate(stmt.expression(), frame);
         std::cout << value.toString() << std::endl;
         return {};
     }
     
-    Object executeWhileStmt(WhileStmt const& stmt, Environment& environment) {
-        while (evaluate(stmt.condition(), environment)) {
-            execute(stmt.body(), environment);
+    Completion executeWhileStmt(WhileStmt const& stmt, Frame& frame) {
+        auto const isEndless = stmt.isEndless();
+        while (isEndless || isTruthy(evaluate(stmt.condition(), frame))) {
+            if (auto completion = execute(stmt.body(), frame); completion.returning) return completion;
+            Lox::heap.safepoint();
+        }
+        return {};
+    }
+
+    // The counter is compared without going through the condition's node, and
+    // needs no root while the limit is evaluated as long as it is a number.
+    Completion executeCountedLoopStmt(CountedLoopStmt const& stmt, Frame& frame) {
+        auto const& operatr = stmt.condition().operatr();
+        auto const& counter = stmt.counter();
+        for (;;) {
+            auto const value = lookupVariable(counter.name(), counter.slot(), frame);
+            auto const holds = [&] {
+                if (value.isDouble()) {
+                    auto const limit = evaluate(stmt.limit(), frame);
+                    if (limit.isDouble()) return numberOperation(operatr, value.asDouble(), limit.asDouble());
+                    return binaryOperation(operatr, value, limit);
+                }
+                auto const valueRoot = Lox::heap.root(value);
+                return binaryOperation(operatr, value, evaluate(stmt.limit(), frame));
+            }();
+            if (!holds) break;
+            if (auto completion = execute(stmt.body(), frame); completion.returning) return completion;
+            Lox::heap.safepoint();
+            evaluateCompoundAssignExpr(stmt.increment(), frame);
         }
         return {};
     }
 
-    Object executeVarStmt(VarStmt const& stmt, Environment& environment) {
-        auto const value = stmt.initializer() ? evaluate(*stmt.initializer(), environment) : Object();
-        environment.define(stmt.name().lexeme(), value);
+    Completion executeVarStmt(VarStmt const& stmt, Frame& frame) {
+        auto const value = stmt.initializer() ? evaluate(*stmt.initializer(), frame) : Object();
+        defineVariable(stmt.slot(), stmt.name(), value, frame);
         return {};
     }
 
-    Object executeBlockStmt(BlockStmt const& stmt, Environment& environment) {
-        auto blockEnvironment = new Environment(&environment);
-        auto result = Object{};
-        std::ranges::for_each(stmt.statements(), [&](auto const* stmt) {
-            assert(stmt && "Statement cannot be null.");
-            result = execute(*stmt, *blockEnvironment);
-        });
+    Completion executeBlockStmt(BlockStmt const& stmt, Frame& frame) {
+        auto result = Completion{};
+        auto const resultRoot = Lox::heap.root(result.value);
+        for (auto const* statement : stmt.statements()) {
+            assert(statement && "Statement cannot be null.");
+            Lox::heap.safepoint();
+            result = execute(*statement, frame);
+            if (result.returning) break;
+        }
         return result;
     }
 
-    Object executeFunctionStmt(FunctionStmt const& stmt, Environment& environment) {
-        environment.define(stmt.name().lexeme(), loxCallableFromFunctionStmt(stmt, environment));
+    Completion executeFunctionStmt(FunctionStmt const& stmt, Frame& frame) {
+        // Declared first, so that the function can capture itself.
+        defineVariable(stmt.slot(), stmt.name(), Object(), frame);
+        assignVariable(stmt.name(), stmt.slot(), loxCallableFromFunctionStmt(stmt, frame), frame);
         return {};
     }
 
-    Object executeReturnStmt(ReturnStmt const& stmt, Environment& environment) {
-        auto const value = stmt.value() ? evaluate(*stmt.value(), environment) : Object{};
-        throw Return{ value };
+    Completion executeReturnStmt(ReturnStmt const& stmt, Frame& frame) {
+        auto const value = stmt.value() ? evaluate(*stmt.value(), frame) : Object{};
+        return { value, true };
     }
 
-    Object executeClassStmt(ClassStmt const& stmt, Environment& environment) {
+    Completion executeClassStmt(ClassStmt const& stmt, Frame& frame) {
         auto const superclass = stmt.superclass() ? [&]() -> std::optional<LoxClass> {
-            auto const superclass = evaluate(*stmt.superclass(), environment);
+            auto const superclass = evaluate(*stmt.superclass(), frame);
             if (!superclass.isLoxClass()) throw RuntimeError(stmt.superclass()->name(), "Superclass must be a class");
             return static_cast<LoxClass>(superclass);
         }() : std::nullopt;
 
-        environment.define(stmt.name().lexeme(), Object());
+        defineVariable(stmt.slot(), stmt.name(), Object(), frame);
 
-        auto const superEnvironment = superclass ? [&]() {
-            auto const superEnvironment = new Environment(&environment);
-            superEnvironment->define("super", *superclass);
-            return superEnvironment;
-        }() : &environment;
+        if (superclass) {
+            defineVariable(stmt.superSlot(), stmt.superclass()->name(), *superclass, frame);
+        }
 
-        auto methods = std::unordered_map<std::string, LoxCallable>();
+        auto methods = std::unordered_map<Symbol, LoxCallable>();
         for (auto method : stmt.methods()) {
-            methods.insert(std::pair(method->name().lexeme(), loxCallableFromFunctionStmt(*method, *superEnvironment, stmt.name().lexeme())));
+            methods.insert(std::pair(method->name().symbol(), loxCallableFromFunctionStmt(*method, frame, stmt.name().lexeme())));
         }
-        environment.assign(stmt.name(), LoxClass(stmt.name().lexeme(), superclass, methods));
+        assignVariable(stmt.name(), stmt.slot(), LoxClass(std::string(stmt.name().lexeme()), superclass, methods), frame);
         return {};
     }
     
 
     // Evaluate function of generic expression:
 
-    template <typename T>
-    using EvaluateExprFuncT = std::function<Object(T const&, Environment&)>;
-
-    Object evaluate(Expr const& expr, Environment& environment) {
-        static auto const evaluateDispatcher = Dispatcher<Object, Expr const&, Environment&>("evaluate expression",
-            EvaluateExprFuncT<BinaryExpr>(evaluateBinaryExpr),
-            EvaluateExprFuncT<GroupingExpr>(evaluateGroupingExpr),
-            EvaluateExprFuncT<LiteralExpr>(evaluateLiteralExpr),
-            EvaluateExprFuncT<UnaryExpr>(evaluateUnaryExpr),
-            EvaluateExprFuncT<VariableExpr>(evaluateVariableExpr),
-            EvaluateExprFuncT<AssignExpr>(evaluateAssignExpr),
-            EvaluateExprFuncT<LogicalExpr>(evaluateLogicalExpr),
-            EvaluateExprFuncT<CallExpr>(evaluateCallExpr),
-            EvaluateExprFuncT<GetExpr>(evaluateGetExpr),
-            EvaluateExprFuncT<SetExpr>(evaluateSetExpr),
-            EvaluateExprFuncT<ThisExpr>(evaluateThisExpr),
-            EvaluateExprFuncT<SuperExpr>(evaluateSuperExpr)
-        );
-
-        return evaluateDispatcher.dispatch(expr, environment);
+    Object evaluate(Expr const& expr, Frame& frame) {
+        static constexpr auto evaluateDispatcher = [] {
+            auto dispatcher = Dispatcher<Object, Expr const&, Frame&>::create<
+                evaluateBinaryExpr,
+                evaluateGroupingExpr,
+                evaluateLiteralExpr,
+                evaluateUnaryExpr,
+                evaluateVariableExpr,
+                evaluateAssignExpr,
+                evaluateLogicalExpr,
+                evaluateCallExpr,
+                evaluateGetExpr,
+                evaluateSetExpr,
+                evaluateThisExpr,
+                evaluateSuperExpr,
+                evaluateCompoundAssignExpr
+            >("evaluate expression");
+            dispatcher.add<ExprKind::NUMBER_BINARY, evaluateNumberBinaryExpr>();
+            return dispatcher;
+        }();
+
+        return evaluateDispatcher.dispatch(expr, frame);
     }
 
     // Execute function of generic statement:
 
-    template <typename T>
-    using ExecuteStmtFuncT = std::function<Object(T const&, Environment& environment)>;
-
-    Object execute(Stmt const& statement, Environment& environment) {
-        static auto const executeDispatcher = Dispatcher<Object, Stmt const&, Environment&>("execute statement",
-            ExecuteStmtFuncT<ExpressionStmt>(executeExpressionStmt),
-            ExecuteStmtFuncT<IfStmt>(executeIfStmt),
-            ExecuteStmtFuncT<PrintStmt>(executePrintStmt),
-            ExecuteStmtFuncT<WhileStmt>(executeWhileStmt),
-            ExecuteStmtFuncT<VarStmt>(executeVarStmt),
-            ExecuteStmtFuncT<BlockStmt>(executeBlockStmt),
-            ExecuteStmtFuncT<FunctionStmt>(executeFunctionStmt),
-            ExecuteStmtFuncT<ReturnStmt>(executeReturnStmt),
-            ExecuteStmtFuncT<ClassStmt>(executeClassStmt)
-        );
-
-        return executeDispatcher.dispatch(statement, environment);
+    Completion execute(Stmt const& statement, Frame& frame) {
+        static constexpr auto executeDispatcher = Dispatcher<Completion, Stmt const&, Frame&>::create<
+            executeExpressionStmt,
+            executeIfStmt,
+            executePrintStmt,
+            executeWhileStmt,
+            executeVarStmt,
+            executeBlockStmt,
+            executeFunctionStmt,
+            executeReturnStmt,
+            executeClassStmt,
+            executeCountedLoopStmt
+        >("execute statement");
+
+        return executeDispatcher.dispatch(statement, frame);
     }
 }
 
 Object interpret(std::vector<Stmt const*> const& statements) {
     try {
         auto result = Object();
+        auto frame = callStack.topLevel();
+        auto const globalsRoot = Lox::heap.root(Lox::globals);
+        auto const callStackRoot = Lox::heap.root(callStack);
+        auto const resultRoot = Lox::heap.root(result);
         for (auto const* statement : statements) {
             assert(statement && "Statement cannot be nullptr");
-            result = execute(*statement, Lox::globals);
+            Lox::heap.safepoint();
+            result = execute(*statement, frame).value;
         }
+        callStack.reset();
         return result;
     }
     catch (RuntimeError const& error) {
+        callStack.reset();
         Lox::error(error.token, error.message);
         return {};
     }
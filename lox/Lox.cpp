@@ -3,11 +3,54 @@
 #include "Lox.h"
 #include "Environment.h"
 #include "Resolver.h"
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <string>
 
+// Where the native stack of a thread ends can be asked for on Linux; elsewhere
+// it is assumed to be no smaller than the 1 MB that Windows gives.
+#if defined(__linux__)
+#define LOX_STACK_BOUNDS 1
+#include <pthread.h>
+#else
+#define LOX_STACK_BOUNDS 0
+#endif
+
 using namespace std::string_literals;
 
+namespace {
+
+    // Native stack kept free for what a call does before the next check, such
+    // as evaluating its arguments, and for reporting the overflow.
+    constexpr std::size_t stackReserve = 256 * 1024;
+
+    // Where the stack of the calling thread currently is.
+    std::uintptr_t stackPosition() {
+        auto const marker = char{};
+        return reinterpret_cast<std::uintptr_t>(&marker);
+    }
+
+    // The lowest address the stack of the calling thread may grow down to.
+    std::uintptr_t stackLimit() {
+        thread_local auto const limit = [] {
+#if LOX_STACK_BOUNDS
+            pthread_attr_t attributes;
+            if (pthread_getattr_np(pthread_self(), &attributes) == 0) {
+                void* lowest = nullptr;
+                std::size_t size = 0;
+                auto const found = pthread_attr_getstack(&attributes, &lowest, &size) == 0;
+                pthread_attr_destroy(&attributes);
+                if (found) return reinterpret_cast<std::uintptr_t>(lowest) + stackReserve;
+            }
+#endif
+            return stackPosition() - (1024 * 1024 - stackReserve);
+        }();
+        return limit;
+    }
+
+}
+
 void Lox::error(int line, std::string message) {
     report(line, "", message);
 }
@@ -22,11 +65,16 @@ void Lox::error(Token const& token, std::string const& message) {
         report(token.line(), " at end", message);
     }
     else {
-        report(token.line(), " at '" + token.lexeme() + "'", message);
+        report(token.line(), " at '" + std::string(token.lexeme()) + "'", message);
     }
 }
 
+bool Lox::nativeStackExhausted() {
+    return stackPosition() < stackLimit();
+}
+
 bool Lox::hadError = false;
 bool Lox::debugEnabled = false;
+int Lox::maxCallDepth = 1000;
+Heap Lox::heap;
 Environment Lox::globals = {};
-ResolvedLocals Lox::locals = {};
@@ -1,21 +1,28 @@
 #pragma once
 
 #include "Resolver.h"
+#include "Heap.h"
 #include <string>
 
 class Environment;
 class Token;
 
-using ResolvedLocals = std::unordered_map<Expr const*, int>;
-
 class Lox {
 public:
     static void error(int line, std::string message);
     static void report(int line, std::string where, std::string message);
     static void error(Token const& token, std::string const& message);
 
+    // Whether the native stack is nearly used up. Calls recurse on it in both
+    // engines, so they check this as well as maxCallDepth.
+    static bool nativeStackExhausted();
+
     static bool hadError;
     static bool debugEnabled;
+    // How deeply calls may nest before the program is stopped with a stack
+    // overflow. Calls that would run out of native stack first are stopped
+    // the same way, however high this is raised.
+    static int maxCallDepth;
+    static Heap heap;
     static Environment globals;
-    static ResolvedLocals locals;
 };
@@ -1,18 +1,50 @@
 #include "LoxCallable.h"
 #include "Object.h"
-#include "Environment.h"
+#include "Lox.h"
+
+class LoxCallable::Function : public GcObject {
+public:
+    Function(FunctionWithReceiverType const& function, Object const& receiver, int arity, std::string const& name, GcObject const* captures)
+        : mFunction(function), mReceiver(receiver), mCaptures(captures), mArity(arity), mName(name) {}
+
+    void trace(Tracer& tracer) const override {
+        tracer.mark(mReceiver);
+        tracer.mark(mCaptures);
+    }
+
+    LoxCallable::FunctionWithReceiverType mFunction;
+    Object mReceiver;
+    GcObject const* mCaptures; // heap state referenced by mFunction, kept alive with the function
+    int mArity;
+    std::string mName;
+};
 
 LoxCallable::LoxCallable(FunctionType const& function, int arity, std::string const& name)
-    : mFunction([function](Environment*, ArgsType args) { return function(args); }), mClosure(nullptr), mArity(arity), mName(name) {
+    : LoxCallable([function](Object const&, ArgsType args) { return function(args); }, arity, name) {
 }
-LoxCallable::LoxCallable(FunctionWithClosureType const& function, Environment* closure, int arity, std::string const& name) 
-    : mFunction(function), mClosure(closure), mArity(arity), mName(name) {
+LoxCallable::LoxCallable(FunctionWithReceiverType const& function, int arity, std::string const& name, GcObject const* captures)
+    : mFunction(Lox::heap.allocate<Function>(function, Object(), arity, name, captures)) {
 }
 Object LoxCallable::operator()(ArgsType arguments) const {
-    return mFunction(mClosure, arguments);
+    // The function may be a temporary, such as a freshly bound initializer.
+    auto const root = Lox::heap.root(*mFunction);
+    return mFunction->mFunction(mFunction->mReceiver, arguments);
+}
+int LoxCallable::arity() const {
+    return mFunction->mArity;
+}
+std::string const& LoxCallable::name() const {
+    return mFunction->mName;
 }
 LoxCallable LoxCallable::bind(LoxInstance const& instance) const {
-    Environment* environment = new Environment(mClosure);
-    environment->define("this", instance);
-    return LoxCallable(mFunction, environment, mArity, mName);
+    return LoxCallable(Lox::heap.allocate<Function>(mFunction->mFunction, instance, mFunction->mArity, mFunction->mName, mFunction->mCaptures));
+}
+Object LoxCallable::call(LoxInstance const& instance, ArgsType arguments) const {
+    auto const receiver = Object(instance);
+    auto const functionRoot = Lox::heap.root(*mFunction);
+    auto const receiverRoot = Lox::heap.root(receiver);
+    return mFunction->mFunction(receiver, arguments);
+}
+void LoxCallable::trace(Tracer& tracer) const {
+    tracer.mark(mFunction);
 }
@@ -1,33 +1,39 @@
 #pragma once
 
 #include <functional>
+#include <span>
 #include <vector>
 #include <string>
 
 class Object;
-class Environment;
 class LoxInstance;
+class GcObject;
+class Tracer;
 
+// Handle to a function owned by Lox::heap; copies refer to the same function.
 class LoxCallable {
 public:
-    using ArgsType = std::vector<Object> const&;
+    // Arguments are viewed where the caller evaluated them, on the stack of
+    // whichever engine is running, and are only valid during the call.
+    using ArgsType = std::span<Object const>;
     using ReturnType = Object;
     using FunctionType = std::function<ReturnType(ArgsType)>;
-    using FunctionWithClosureType = std::function<ReturnType(Environment*, ArgsType)>;
+    // Receives the instance a method is bound to or called on, nil otherwise.
+    using FunctionWithReceiverType = std::function<ReturnType(Object const&, ArgsType)>;
     LoxCallable(FunctionType const& function, int arity, std::string const& name);
-    LoxCallable(FunctionWithClosureType const& function, Environment* closure, int arity, std::string const& name);
+    LoxCallable(FunctionWithReceiverType const& function, int arity, std::string const& name, GcObject const* captures = nullptr);
     Object operator()(ArgsType arguments) const;
-    int arity() const { return mArity; };
-    std::string const& name() const { return mName; };
+    int arity() const;
+    std::string const& name() const;
     LoxCallable bind(LoxInstance const& instance) const;
+    // Calls a method with `this` bound to instance, without creating a bound
+    // method first.
+    Object call(LoxInstance const& instance, ArgsType arguments) const;
+    void trace(Tracer& tracer) const;
 private:
-    
-    LoxCallable::FunctionWithClosureType mFunction;
-    Environment* mClosure;
-    int mArity;
-    std::string mName;
-};
+    friend class Object;
+    class Function;
+    explicit LoxCallable(Function* function) : mFunction(function) {}
 
-inline bool operator ==(LoxCallable const& lhs, LoxCallable const& rhs) {
-    return false;
-}
+    Function* mFunction;
+};
@@ -1,46 +1,83 @@
 #include "LoxClass.h"
-#include "LoxClass.h"
-#include "LoxClass.h"
 #include "Object.h"
 #include "LoxCallable.h"
+#include "Shape.h"
+#include "Lox.h"
 #include <cassert>
 
-class LoxClass::Methods {
+namespace {
+
+    Symbol const initializerName("init");
+
+}
+
+// The method table is flattened when the class is defined: inherited methods
+// are copied in and then overridden by the class's own, so finding a method is
+// a single probe however deep the hierarchy is.
+class LoxClass::Methods : public GcObject {
 public:
-    Methods(std::unordered_map<std::string, LoxCallable> const& methods, std::optional<LoxClass> const& superclass) 
-        : mMethods(methods), mSuperclassMethods(superclass ? superclass->mMethods : nullptr) {}
+    Methods(std::string const& name, std::unordered_map<Symbol, LoxCallable> const& methods, std::optional<LoxClass> const& superclass)
+        : mName(name), mMethods(superclass ? superclass->mMethods->mMethods : std::unordered_map<Symbol, LoxCallable>()) {
+        for (auto const& [methodName, method] : methods) {
+            mMethods.insert_or_assign(methodName, method);
+        }
+        mInitializer = findMethod(initializerName);
+    }
+    ~Methods() override { ++freedClasses; }
+
+    std::string const& name() const { return mName; }
+    Shape const* shape() const { return &mShape; }
+    Object const& initializer() const { return mInitializer; }
 
-    Object findMethod(std::string const& name) const {
-        if (mMethods.contains(name)) return mMethods.at(name);
-        if (mSuperclassMethods) return mSuperclassMethods->findMethod(name);
+    Object findMethod(Symbol name) const {
+        if (auto const it = mMethods.find(name); it != mMethods.end()) return it->second;
         return Object();
     }
+    void trace(Tracer& tracer) const override {
+        for (auto const& [name, method] : mMethods) {
+            method.trace(tracer);
+        }
+    }
 private:
-    std::unordered_map<std::string, LoxCallable> mMethods;
-    std::shared_ptr<const Methods> mSuperclassMethods;
+    std::string mName;
+    std::unordered_map<Symbol, LoxCallable> mMethods;
+    Object mInitializer;
+    Shape mShape;
 };
 
-LoxClass::LoxClass(std::string const& name, std::optional<LoxClass> const& superclass, std::unordered_map<std::string, LoxCallable> const& methods)
-    : mName(name), mMethods(new Methods(methods, superclass)) {
+LoxClass::LoxClass(std::string const& name, std::optional<LoxClass> const& superclass, std::unordered_map<Symbol, LoxCallable> const& methods)
+    : mMethods(Lox::heap.allocate<Methods>(name, methods, superclass)) {
+}
+
+std::string const& LoxClass::name() const {
+    return mMethods->name();
 }
 
 int LoxClass::arity() const { 
-    auto const initializer = findMethod("init");
+    auto const& initializer = mMethods->initializer();
     if (initializer.isLoxCallable()) {
         return static_cast<LoxCallable>(initializer).arity();
     }
     return 0;
 }
 
-LoxInstance LoxClass::operator()(std::vector<Object> const& arguments) const {
+LoxInstance LoxClass::operator()(std::span<Object const> arguments) const {
     auto const instance = LoxInstance(*this);
-    auto const initializer = findMethod("init");
+    auto const& initializer = mMethods->initializer();
     if (initializer.isLoxCallable()) {
-        static_cast<LoxCallable>(initializer).bind(instance)(arguments);
+        static_cast<LoxCallable>(initializer).call(instance, arguments);
     }
     return instance;
 }
 
-Object LoxClass::findMethod(std::string const& name) const {
+Object LoxClass::findMethod(Symbol name) const {
     return mMethods->findMethod(name);
 }
+
+Shape const* LoxClass::shape() const {
+    return mMethods->shape();
+}
+
+void LoxClass::trace(Tracer& tracer) const {
+    tracer.mark(mMethods);
+}
@@ -3,24 +3,41 @@
 class Object;
 class LoxInstance;
 class LoxCallable;
+class Tracer;
+class Symbol;
+class Shape;
 
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <optional>
-#include <memory>
+#include <span>
 #include <unordered_map>
 
+// Handle to a class owned by Lox::heap; copies refer to the same class.
 class LoxClass {
 public:
-    LoxClass(std::string const& name, std::optional<LoxClass> const& superclass, std::unordered_map<std::string, LoxCallable> const& methods);
-    std::string const& name() const { return mName; }
+    LoxClass(std::string const& name, std::optional<LoxClass> const& superclass, std::unordered_map<Symbol, LoxCallable> const& methods);
+    std::string const& name() const;
     int arity() const;
-    LoxInstance operator()(std::vector<Object> const& arguments) const;
-    Object findMethod(std::string const& name) const;
+    LoxInstance operator()(std::span<Object const> arguments) const;
+    Object findMethod(Symbol name) const;
+    // The shape of a new instance, with no fields.
+    Shape const* shape() const;
+    void trace(Tracer& tracer) const;
+
+    // Distinguishes classes without keeping them alive. The identity of a
+    // freed class may be reused by a new one; generation() changes whenever a
+    // class is freed.
+    void const* identity() const { return mMethods; }
+    static std::size_t generation() { return freedClasses; }
 
 private:
+    friend class Object;
     class Methods;
-    std::string mName;
-    std::shared_ptr<const Methods> mMethods;
+    static inline std::size_t freedClasses = 0;
+    explicit LoxClass(Methods const* methods) : mMethods(methods) {}
+
+    Methods const* mMethods;
 
 };
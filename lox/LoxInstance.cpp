@@ -1,45 +1,114 @@
 #include "LoxInstance.h"
-#include "LoxInstance.h"
-#include "LoxInstance.h"
 #include "LoxClass.h"
+#include "InlineCache.h"
+#include "Shape.h"
 #include "RuntimeError.h"
 #include "Token.h"
+#include "Lox.h"
 #include <cassert>
-#include <unordered_map>
 
-class LoxInstance::Fields {
+namespace {
+
+    struct Property {
+        Object value;
+        bool isMethod;
+    };
+
+    Object bound(Property const& property, LoxInstance const& instance) {
+        if (!property.isMethod) return property.value;
+        return static_cast<LoxCallable>(property.value).bind(instance);
+    }
+
+}
+
+// Field values live in a dense array laid out by the instance's shape.
+class LoxInstance::Fields : public GcObject {
 public:
-    Object get(Token const& name, LoxClass const& klass, LoxInstance const& instance) const {
-        if (auto const it = mFields.find(name.lexeme()); it != mFields.end()) {
-            return it->second;
+    explicit Fields(LoxClass const& klass) : mClass(klass), mShape(klass.shape()) {}
+
+    LoxClass const& klass() const { return mClass; }
+
+    Property lookup(Token const& name, InlineCache const* cache) const {
+        if (auto const entry = cache ? cache->find(mShape) : nullptr) {
+            if (entry->slot >= 0) return { mValues[entry->slot], false };
+            return { entry->method, true };
         }
 
-        auto const method = klass.findMethod(name.lexeme());
+        if (auto const slot = mShape->find(name.symbol()); slot >= 0) {
+            if (cache) cache->insert({ .key = mShape, .slot = slot });
+            return { mValues[slot], false };
+        }
+
+        auto const method = mClass.findMethod(name.symbol());
 
         if (method != Object()) {
             assert(method.isLoxCallable());
-            return static_cast<LoxCallable>(method).bind(instance);
+            if (cache) cache->insert({ .key = mShape, .method = method });
+            return { method, true };
         }
 
-        throw RuntimeError{ name, "Undefined property '" + name.lexeme() + "'." };
+        throw RuntimeError{ name, "Undefined property '" + std::string(name.lexeme()) + "'." };
     }
-    void set(Token const& name, Object const& object) {
-        mFields[name.lexeme()] = object;
+    void set(Token const& name, Object const& object, InlineCache const* cache) {
+        if (auto const entry = cache ? cache->find(mShape) : nullptr) {
+            if (entry->transition) add(entry->transition, object);
+            else mValues[entry->slot] = object;
+            return;
+        }
+
+        if (auto const slot = mShape->find(name.symbol()); slot >= 0) {
+            if (cache) cache->insert({ .key = mShape, .slot = slot });
+            mValues[slot] = object;
+        }
+        else {
+            auto const transition = mShape->with(name.symbol());
+            if (cache) cache->insert({ .key = mShape, .transition = transition });
+            add(transition, object);
+        }
+    }
+    void trace(Tracer& tracer) const override {
+        tracer.mark(mValues);
+        mClass.trace(tracer);
     }
 private:
-    std::unordered_map<std::string, Object> mFields;
+    void add(Shape const* shape, Object const& object) {
+        mShape = shape;
+        mValues.push_back(object);
+    }
+
+    LoxClass mClass;
+    Shape const* mShape;
+    std::vector<Object> mValues;
 };
 
-LoxInstance::LoxInstance(LoxClass const& klass) : mClass(klass), mFields(new LoxInstance::Fields()) {}
+LoxInstance::LoxInstance(LoxClass const& klass) : mFields(Lox::heap.allocate<LoxInstance::Fields>(klass)) {}
 
 LoxClass const& LoxInstance::klass() const { 
-    return mClass;
+    return mFields->klass();
 }
 
 Object LoxInstance::get(Token const& name) const {
-    return mFields->get(name, mClass, *this);
+    return bound(mFields->lookup(name, nullptr), *this);
 }
 
 void LoxInstance::set(Token const& name, Object const& object) {
-    mFields->set(name, object);
+    mFields->set(name, object, nullptr);
+}
+
+Object LoxInstance::get(Token const& name, InlineCache const& cache) const {
+    return bound(mFields->lookup(name, &cache), *this);
+}
+
+void LoxInstance::set(Token const& name, Object const& object, InlineCache const& cache) {
+    mFields->set(name, object, &cache);
+}
+
+std::optional<LoxCallable> LoxInstance::method(Token const& name, InlineCache const& cache) const {
+    auto const property = mFields->lookup(name, &cache);
+    if (!property.isMethod) return std::nullopt;
+    return static_cast<LoxCallable>(property.value);
+}
+
+void LoxInstance::trace(Tracer& tracer) const {
+    tracer.mark(mFields);
 }
@@ -1,18 +1,30 @@
 #pragma once
+#include <optional>
 #include <string>
-#include <memory>
 #include "LoxClass.h"
 class Token;
+class Tracer;
+class InlineCache;
 
+// Handle to an instance owned by Lox::heap; copies refer to the same instance.
 class LoxInstance {
 public:
     explicit LoxInstance(LoxClass const& klass);
     LoxClass const& klass() const;
     Object get(Token const& name) const;
     void set(Token const& name, Object const& value);
+    // Overloads that look fields and methods up through a call site's cache.
+    Object get(Token const& name, InlineCache const& cache) const;
+    void set(Token const& name, Object const& value, InlineCache const& cache);
+    // The method name refers to, unbound, for call sites that invoke it on
+    // this instance right away. Nothing when name is a field.
+    std::optional<LoxCallable> method(Token const& name, InlineCache const& cache) const;
+    void trace(Tracer& tracer) const;
 
 private:
+    friend class Object;
     class Fields;
-    LoxClass mClass;
-    std::shared_ptr<Fields> mFields;
+    explicit LoxInstance(Fields* fields) : mFields(fields) {}
+
+    Fields* mFields;
 };
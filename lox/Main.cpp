@@ -6,31 +6,46 @@
 #include "Environment.h"
 #include "LoxCallable.h"
 #include "Resolver.h"
+#include "Optimizer.h"
+#include "StmtToString.h"
+#include "Compiler.h"
+#include "Chunk.h"
+#include "VM.h"
+#include "InlineCache.h"
+#include "Source.h"
 #include <iostream>
-#include <fstream>
+#include <utility>
 #include <algorithm>
 #include <chrono>
+#include <cstdlib>
 
 using namespace std::string_literals;
 
 namespace {
 
+    bool useBytecode = false;
+    bool dumpTree = false;
+
+    // Programs whose function declarations may still be reachable from the
+    // globals. Everything else is freed as soon as it has run.
+    std::vector<Program> retainedPrograms;
+
     void addNativeFunctionsToGlobalEnvironment() {
-        Lox::globals.define("clock", LoxCallable([](std::vector<Object> const&) {
+        Lox::globals.define(Symbol("clock"), LoxCallable([](LoxCallable::ArgsType) {
             return static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
             }, 0, "clock (native)"));
 
-        Lox::globals.define("monkey", LoxCallable([](std::vector<Object> const&) {
+        Lox::globals.define(Symbol("monkey"), LoxCallable([](LoxCallable::ArgsType) {
             return "      __        \n w  c(..)o   (  \n  \\__(-)    __) \n      /\\   (    \n     /(_)___)   \n     w /|       \n      | \\       \n     m  m       "s;
             }, 0, "monkey (native)"));
 
-        Lox::globals.define("readString", LoxCallable([](std::vector<Object> const&) {
+        Lox::globals.define(Symbol("readString"), LoxCallable([](LoxCallable::ArgsType) {
             std::string s;
             std::cin >> s;
             return s;
             }, 0, "readString (native)"));
 
-        Lox::globals.define("subString", LoxCallable([](std::vector<Object> const& arguments) {
+        Lox::globals.define(Symbol("subString"), LoxCallable([](LoxCallable::ArgsType arguments) {
             auto const string = static_cast<std::string>(arguments[0]);
             auto const offd = static_cast<double>(arguments[1]);
             auto const countd = static_cast<double>(arguments[2]);
@@ -41,32 +56,45 @@ namespace {
 
     }
 
-    void run(std::string source) {
-
-        auto const tScanTokensStart = std::chrono::high_resolution_clock::now();
-        auto const tokens = scanTokens(source);
-        auto const tScanTokensEnd = std::chrono::high_resolution_clock::now();
-
-        if (Lox::debugEnabled) {
-            std::cout << "Tokens: ";
-            std::ranges::for_each(tokens, [first = true](Token const& token) mutable { std::cout << (first ? "" : ", ") << "[" << token.toString() << "]"; first = false; });
-            std::cout << std::endl;
-        }
+    void run(Source source) {
 
+        // The parser pulls tokens from the scanner as it goes, and the program
+        // keeps the source they view.
         auto const tParseStart = std::chrono::high_resolution_clock::now();
-        auto const statements = parse(tokens);
+        auto program = parse(std::move(source));
+        auto const& statements = program.statements();
         auto const tParseEnd = std::chrono::high_resolution_clock::now();
 
         if (Lox::debugEnabled) {
-            std::cout << "Num statements: " << statements.size() << std::endl;
+            // The debug keyword is only seen while parsing, so the listing scans again.
+            std::cout << "Tokens: ";
+            std::ranges::for_each(scanTokens(program.source()), [first = true](Token const& token) mutable { std::cout << (first ? "" : ", ") << "[" << token.toString() << "]"; first = false; });
+            std::cout << std::endl;
+            std::cout << "Num statements: " << statements.size() << " (" << program.bytesAllocated() << " bytes)" << std::endl;
         }
 
         auto const tResolveStart = std::chrono::high_resolution_clock::now();
         resolve(statements);
         auto const tResolveEnd = std::chrono::high_resolution_clock::now();
 
+        auto const tOptimizeStart = std::chrono::high_resolution_clock::now();
+        if (!Lox::hadError) optimize(program);
+        auto const tOptimizeEnd = std::chrono::high_resolution_clock::now();
+
+        if (dumpTree && !Lox::hadError) {
+            std::ranges::for_each(statements, [](Stmt const* statement) { std::cout << toString(*statement) << std::endl; });
+        }
+
+        auto const tCompileStart = std::chrono::high_resolution_clock::now();
+        auto const script = useBytecode && !Lox::hadError ? compile(statements) : nullptr;
+        auto const tCompileEnd = std::chrono::high_resolution_clock::now();
+
+        if (Lox::debugEnabled && script) {
+            std::cout << disassemble(*script);
+        }
+
         auto const tInterpretStart = std::chrono::high_resolution_clock::now();
-        auto const result = Lox::hadError ? Object{} : interpret(statements);
+        auto const result = Lox::hadError ? Object{} : script ? interpret(*script) : interpret(statements);
         auto const tInterpretEnd = std::chrono::high_resolution_clock::now();
 
         if (!result.isNil()) {
@@ -74,18 +102,33 @@ namespace {
         }
 
         if (Lox::debugEnabled) {
-            std::cout << "Scanner: " << std::chrono::duration_cast<std::chrono::microseconds>(tScanTokensEnd - tScanTokensStart) << std::endl;
-            std::cout << "Parser: " << std::chrono::duration_cast<std::chrono::microseconds>(tParseEnd - tParseStart) << std::endl;
+            std::cout << "Scanner and parser: " << std::chrono::duration_cast<std::chrono::microseconds>(tParseEnd - tParseStart) << std::endl;
             std::cout << "Resolver: " << std::chrono::duration_cast<std::chrono::microseconds>(tResolveEnd - tResolveStart) << std::endl;
+            std::cout << "Optimizer: " << std::chrono::duration_cast<std::chrono::microseconds>(tOptimizeEnd - tOptimizeStart) << std::endl;
+            if (useBytecode) std::cout << "Compiler: " << std::chrono::duration_cast<std::chrono::microseconds>(tCompileEnd - tCompileStart) << std::endl;
             std::cout << "Interpreter: " << std::chrono::duration_cast<std::chrono::microseconds>(tInterpretEnd - tInterpretStart) << std::endl;
+            auto const& gc = Lox::heap.stats();
+            std::cout << "GC: " << gc.collections << " collections, " << gc.liveObjects() << " live objects (" << gc.liveBytes() << " bytes), "
+                << gc.objectsFreed << " of " << gc.objectsAllocated << " objects freed" << std::endl;
+            auto const& caches = InlineCache::stats;
+            std::cout << "Inline caches: " << caches.hits << " hits, " << caches.misses << " misses" << std::endl;
+        }
+
+        // Compiled functions copy what they need out of the tree, but their
+        // tokens still view the program's source.
+        if (program.declaresFunctions()) {
+            retainedPrograms.push_back(std::move(program));
         }
     }
 
-    void runFile(std::string fileName) {
-        std::ifstream t(fileName);
-        std::stringstream buffer;
-        buffer << t.rdbuf();
-        run(buffer.str());
+    bool runFile(std::string const& fileName) {
+        auto source = Source::fromFile(fileName);
+        if (!source) {
+            std::cerr << "Could not read " << fileName << std::endl;
+            return false;
+        }
+        run(std::move(*source));
+        return true;
     }
 
     void runPrompt() {
@@ -94,7 +137,7 @@ namespace {
             std::string line;
             getline(std::cin, line);
             if (line == "exit" || line == "q") return;
-            run(line);
+            run(Source(std::move(line)));
             Lox::hadError = false;
         }
     }
@@ -106,12 +149,31 @@ int main(int argc, char* argv[])
 
     addNativeFunctionsToGlobalEnvironment();
 
-    if (argc > 2) {
-        std::cerr << "Usage: lox [script]" << std::endl;
+    while (argc > 1 && std::string(argv[1]).starts_with("--")) {
+        if (argv[1] == "--vm"s) {
+            useBytecode = true;
+        }
+        else if (argv[1] == "--dump-ast"s) {
+            dumpTree = true;
+        }
+        else if (argv[1] == "--max-depth"s && argc > 2) {
+            Lox::maxCallDepth = std::max(1, std::atoi(argv[2]));
+            --argc;
+            ++argv;
+        }
+        else {
+            break;
+        }
+        --argc;
+        ++argv;
+    }
+
+    if (argc > 2 || (argc == 2 && std::string(argv[1]).starts_with("--"))) {
+        std::cerr << "Usage: lox [--vm] [--dump-ast] [--max-depth N] [script]" << std::endl;
         return EXIT_FAILURE;
     }
     else if (argc == 2) {
-        runFile(argv[1]);
+        if (!runFile(argv[1])) return EXIT_FAILURE;
     }
     else {
         runPrompt();
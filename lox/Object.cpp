@@ -1,101 +1,78 @@
 #include "Object.h"
+#include <charconv>
 #include <stdexcept>
-#include <ranges>
-
-namespace r = std::ranges;
-namespace rv = std::ranges::views;
+#include <string_view>
 
 namespace {
 
+    // The shortest text that reads back as x, in fixed or scientific notation
+    // whichever is shorter. Whole numbers in fixed notation end in .0.
     std::string doubleToString(double x) {
-        auto s = std::to_string(x);
-        s.erase(r::find_if(s | rv::reverse, [](auto ch) {
-            return ch != '0';
-            }).base(), s.end());
-        if (s.back() == '.') s += '0';
-        return s;
+        char buffer[32];
+        auto const end = std::to_chars(buffer, buffer + sizeof buffer, x).ptr;
+        auto text = std::string(buffer, end);
+        if (std::string_view(buffer, end).find_first_of(".ein") == std::string_view::npos) text += ".0";
+        return text;
     }
 
 }
 
+Object::Object(std::string const& string) : mBits(boxPointer(Symbol::intern(string), stringTag)) {
+    retain();
+}
+
+Object::Object(std::string_view string) : mBits(boxPointer(Symbol::intern(string), stringTag)) {
+    retain();
+}
+
+Object::Object(Symbol symbol) : mBits(boxPointer(symbol.entry(), stringTag)) {
+    retain();
+}
+
 std::string Object::toString() const {
-    if (isString()) return std::get<std::string>(mData);
-    else if (isDouble()) return doubleToString(std::get<double>(mData));
-    else if (isBoolean()) return std::get<bool>(mData) ? "true" : "false";
+    if (isString()) return unboxPointer<String>()->value();
+    else if (isDouble()) return doubleToString(static_cast<double>(*this));
+    else if (isBoolean()) return static_cast<bool>(*this) ? "true" : "false";
     else if (isNil()) return "Nil";
     else if (isLoxCallable()) {
-        auto const name = std::get<LoxCallable>(mData).name();
+        auto const& name = static_cast<LoxCallable>(*this).name();
         if (name.empty()) return "<fn>";
         else return "<fn " + name + ">";
     }
     else if (isLoxClass()) {
-        auto const name = std::get<LoxClass>(mData).name();
+        auto const& name = static_cast<LoxClass>(*this).name();
         if (name.empty()) return "<class>";
         else return "<class " + name + ">";
     }
     else if (isLoxInstance()) {
-        auto const className = std::get<LoxInstance>(mData).klass().name();
+        auto const& className = static_cast<LoxInstance>(*this).klass().name();
         return "<" + className + " instance>";
     }
     else return "unknown type";
 }
 
 Object::operator std::string() const {
-    if (!isString()) throw std::runtime_error("Cannot convert " + typeAsString() + " to String");
-    return std::get<std::string>(mData);
-}
-
-Object::operator double() const {
-    if (!isDouble()) throw std::runtime_error("Cannot convert " + typeAsString() + " to Double");
-    return std::get<double>(mData);
-}
-
-Object::operator bool() const {
-    if (!isBoolean()) throw std::runtime_error("Cannot convert " + typeAsString() + " to Boolean");
-    return std::get<bool>(mData);
+    if (!isString()) conversionError("String");
+    return unboxPointer<String>()->value();
 }
 
 Object::operator LoxCallable() const {
-    if (!isLoxCallable()) throw std::runtime_error("Cannot convert " + typeAsString() + " to LoxCallable");
-    return std::get<LoxCallable>(mData);
+    if (!isLoxCallable()) conversionError("LoxCallable");
+    return LoxCallable(unboxPointer<LoxCallable::Function>());
 }
 
 Object::operator LoxClass() const {
-    if (!isLoxClass()) throw std::runtime_error("Cannot convert " + typeAsString() + " to LoxClass");
-    return std::get<LoxClass>(mData);
+    if (!isLoxClass()) conversionError("LoxClass");
+    return LoxClass(unboxPointer<LoxClass::Methods const>());
 }
 
 Object::operator LoxInstance() const {
-    if (!isLoxInstance()) throw std::runtime_error("Cannot convert " + typeAsString() + " to LoxInstance");
-    return std::get<LoxInstance>(mData);
-}
-
-bool Object::isString() const {
-    return std::holds_alternative<std::string>(mData);
+    if (!isLoxInstance()) conversionError("LoxInstance");
+    return LoxInstance(unboxPointer<LoxInstance::Fields>());
 }
 
-bool Object::isDouble() const {
-    return std::holds_alternative<double>(mData);
-}
-
-bool Object::isBoolean() const {
-    return std::holds_alternative<bool>(mData);
-}
-
-bool Object::isLoxCallable() const {
-    return std::holds_alternative<LoxCallable>(mData);
-}
-
-bool Object::isLoxClass() const {
-    return std::holds_alternative<LoxClass>(mData);
-}
-
-bool Object::isLoxInstance() const {
-    return std::holds_alternative<LoxInstance>(mData);
-}
-
-bool Object::isNil() const {
-    return std::holds_alternative<Nil>(mData);
+void Object::conversionError(std::string const& type) const {
+    throw std::runtime_error("Cannot convert " + typeAsString() + " to " + type);
 }
 
 inline std::string Object::typeAsString() const noexcept {
@@ -109,8 +86,16 @@ inline std::string Object::typeAsString() const noexcept {
     else return "Unknown type";
 }
 
+void Object::trace(Tracer& tracer) const {
+    if (isLoxCallable()) static_cast<LoxCallable>(*this).trace(tracer);
+    else if (isLoxClass()) static_cast<LoxClass>(*this).trace(tracer);
+    else if (isLoxInstance()) static_cast<LoxInstance>(*this).trace(tracer);
+}
+
 bool operator==(Object const& lhs, Object const& rhs) {
-    return lhs.mData == rhs.mData;
+    if (lhs.isDouble() && rhs.isDouble()) return static_cast<double>(lhs) == static_cast<double>(rhs);
+    // Strings are interned, so everything else compares by identity.
+    return lhs.mBits == rhs.mBits;
 }
 
 std::ostream& operator<<(std::ostream& os, Object const& object) {
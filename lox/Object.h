@@ -3,49 +3,128 @@
 #include "LoxCallable.h"
 #include "LoxClass.h"
 #include "LoxInstance.h"
+#include "Symbol.h"
+#include <bit>
+#include <cassert>
+#include <cstdint>
 #include <string>
-#include <variant>
+#include <utility>
 #include <iostream>
 
-class Nil {};
-inline bool operator == (Nil, Nil) { return true; }
+class Tracer;
 
+// A NaN-boxed 64-bit value. Numbers are stored as plain doubles; nil, booleans
+// and pointers live in the payload of a quiet NaN that arithmetic never
+// produces. Pointers carry their type in the two low bits, which are free since
+// heap allocations are at least 8-byte aligned.
+//
+// Strings are interned Symbol entries shared through a reference count, so two
+// equal strings are the same pointer. Functions, classes and instances are owned
+// by Lox::heap, so copying an Object never touches them.
 class Object {
 public:
 
-    Object(std::string string) : mData(string) {}
-    Object(double dbl) : mData(dbl) {}
-    Object(bool boolean) : mData(boolean) {}
-    Object(LoxCallable const& loxCallable) : mData(loxCallable) {}
-    Object(LoxClass const& loxClass) : mData(loxClass) {}
-    Object(LoxInstance const& loxInstance) : mData(loxInstance) {}
-    Object() : mData(Nil{}) {}
+    Object(std::string const& string);
+    Object(std::string_view string);
+    Object(Symbol symbol);
+    Object(double dbl) : mBits(std::bit_cast<std::uint64_t>(dbl == dbl ? dbl : canonicalNaN)) {}
+    Object(bool boolean) : mBits(boolean ? trueBits : falseBits) {}
+    Object(LoxCallable const& loxCallable) : mBits(boxPointer(loxCallable.mFunction, callableTag)) {}
+    Object(LoxClass const& loxClass) : mBits(boxPointer(loxClass.mMethods, classTag)) {}
+    Object(LoxInstance const& loxInstance) : mBits(boxPointer(loxInstance.mFields, instanceTag)) {}
+    Object() : mBits(nilBits) {}
     Object(char const*) = delete;
     Object(int) = delete;
 
+    Object(Object const& other) : mBits(other.mBits) { retain(); }
+    Object(Object&& other) noexcept : mBits(std::exchange(other.mBits, nilBits)) {}
+    Object& operator=(Object const& other) {
+        other.retain();
+        release();
+        mBits = other.mBits;
+        return *this;
+    }
+    Object& operator=(Object&& other) noexcept {
+        std::swap(mBits, other.mBits);
+        return *this;
+    }
+    ~Object() { release(); }
+
     std::string toString() const;
 
     explicit operator std::string() const;
-    explicit operator double() const;
-    explicit operator bool() const;
+    explicit operator double() const {
+        if (!isDouble()) conversionError("Double");
+        return std::bit_cast<double>(mBits);
+    }
+    // The number, for callers that have checked isDouble() already.
+    double asDouble() const {
+        assert(isDouble());
+        return std::bit_cast<double>(mBits);
+    }
+    explicit operator bool() const {
+        if (!isBoolean()) conversionError("Boolean");
+        return mBits == trueBits;
+    }
     explicit operator LoxCallable() const;
     explicit operator LoxClass() const;
     explicit operator LoxInstance() const;
-    
-    bool isString() const;
-    bool isDouble() const;
-    bool isBoolean() const;
-    bool isLoxCallable() const;
-    bool isLoxClass() const;
-    bool isLoxInstance() const;
-    bool isNil() const;
+
+    bool isString() const { return hasTag(stringTag); }
+    bool isDouble() const { return (mBits & quietNaN) != quietNaN; }
+    bool isBoolean() const { return (mBits | 1) == trueBits; }
+    bool isLoxCallable() const { return hasTag(callableTag); }
+    bool isLoxClass() const { return hasTag(classTag); }
+    bool isLoxInstance() const { return hasTag(instanceTag); }
+    bool isNil() const { return mBits == nilBits; }
+
+    void trace(Tracer& tracer) const;
 
     friend bool operator == (Object const& lhs, Object const& rhs);
 
 private:
+    using String = Symbol::Entry;
+
+    static constexpr std::uint64_t signBit = 0x8000000000000000;
+    static constexpr std::uint64_t quietNaN = 0x7ffc000000000000;
+    static constexpr std::uint64_t nilBits = quietNaN | 1;
+    static constexpr std::uint64_t falseBits = quietNaN | 2;
+    static constexpr std::uint64_t trueBits = quietNaN | 3;
+    static constexpr std::uint64_t tagMask = 3;
+    static constexpr std::uint64_t stringTag = 0;
+    static constexpr std::uint64_t callableTag = 1;
+    static constexpr std::uint64_t classTag = 2;
+    static constexpr std::uint64_t instanceTag = 3;
+    static constexpr double canonicalNaN = std::bit_cast<double>(0x7ff8000000000000ull);
+
+    static std::uint64_t boxPointer(void const* pointer, std::uint64_t tag) {
+        return signBit | quietNaN | reinterpret_cast<std::uintptr_t>(pointer) | tag;
+    }
+    template <class T>
+    T* unboxPointer() const {
+        return reinterpret_cast<T*>(static_cast<std::uintptr_t>(mBits & ~(signBit | quietNaN | tagMask)));
+    }
+    bool hasTag(std::uint64_t tag) const {
+        return (mBits & (signBit | quietNaN | tagMask)) == (signBit | quietNaN | tag);
+    }
+
+    void retain() const;
+    void release();
+    [[noreturn]] void conversionError(std::string const& type) const;
     std::string typeAsString() const noexcept;
-    std::variant<std::string, double, bool, Nil, LoxCallable, LoxClass, LoxInstance> mData;
+
+    std::uint64_t mBits;
 
 };
 
+static_assert(sizeof(Object) == 8);
+
+inline void Object::retain() const {
+    if (isString()) unboxPointer<String>()->retain();
+}
+
+inline void Object::release() {
+    if (isString()) unboxPointer<String>()->release();
+}
+
 std::ostream& operator<<(std::ostream& os, Object const& object);
@@ -0,0 +1,341 @@
+#include "Optimizer.h"
+#include "Dispatcher.h"
+#include "Expr.h"
+#include "Stmt.h"
+#include "Program.h"
+#include "Object.h"
+#include "TokenType.h"
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+    // Forward declaration of generic optimize functions. Expressions come back
+    // unchanged or as their replacement, statements as nullptr when removed.
+    Expr const* optimize(Expr const& expr, Program& program);
+    Stmt const* optimize(Stmt const& stmt, Program& program);
+    std::vector<Stmt const*> optimize(std::vector<Stmt const*> const& statements, Program& program);
+
+    // Utility functions used in the concrete optimize functions
+
+    LiteralExpr const* literal(Expr const& expr) {
+        return expr.kind() == ExprKind::LITERAL ? &static_cast<LiteralExpr const&>(expr) : nullptr;
+    }
+
+    bool isTruthy(Object const& object) {
+        if (object.isNil()) return false;
+        if (object.isBoolean()) return (bool)object;
+        return true;
+    }
+
+    bool isArithmetic(TokenType type) {
+        return type == TokenType::PLUS || type == TokenType::MINUS || type == TokenType::STAR || type == TokenType::SLASH;
+    }
+
+    bool isComparison(TokenType type) {
+        return type == TokenType::LESS || type == TokenType::LESS_EQUAL || type == TokenType::GREATER || type == TokenType::GREATER_EQUAL
+            || type == TokenType::EQUAL_EQUAL || type == TokenType::BANG_EQUAL;
+    }
+
+    // Whether an expression reads the variable with the given name and slot.
+    bool isVariable(Expr const& expr, Token const& name, VariableSlot const& slot) {
+        if (expr.kind() != ExprKind::VARIABLE) return false;
+        auto const& variable = static_cast<VariableExpr const&>(expr);
+        return variable.name().lexeme() == name.lexeme() && variable.slot().kind == slot.kind && variable.slot().index == slot.index;
+    }
+
+    // Branches and loop bodies need a statement even when theirs was removed.
+    Stmt const* orEmpty(Stmt const* stmt, Program& program) {
+        return stmt ? stmt : program.make<BlockStmt>(std::vector<Stmt const*>{});
+    }
+
+    // The value of an operator applied to two literals, or nothing if applying
+    // it is an error, which is left for run time to report.
+    std::optional<Object> fold(Token const& operatr, Object const& left, Object const& right) {
+        switch (operatr.tokenType()) {
+        case TokenType::PLUS:
+            if (left.isString() || right.isString()) return Object(left.toString() + right.toString());
+            break;
+        case TokenType::BANG_EQUAL:
+            return Object(left != right);
+        case TokenType::EQUAL_EQUAL:
+            return Object(left == right);
+        default:
+            break;
+        }
+
+        if (!left.isDouble() || !right.isDouble()) return std::nullopt;
+        auto const l = static_cast<double>(left);
+        auto const r = static_cast<double>(right);
+        switch (operatr.tokenType()) {
+        case TokenType::MINUS: return Object(l - r);
+        case TokenType::PLUS: return Object(l + r);
+        case TokenType::SLASH: return Object(l / r);
+        case TokenType::STAR: return Object(l * r);
+        case TokenType::GREATER: return Object(l > r);
+        case TokenType::GREATER_EQUAL: return Object(l >= r);
+        case TokenType::LESS: return Object(l < r);
+        case TokenType::LESS_EQUAL: return Object(l <= r);
+        default: return std::nullopt;
+        }
+    }
+
+    // Optimize functions of concrete expressions:
+    Expr const* optimizeBinaryExpr(BinaryExpr const& expr, Program& program) {
+        auto const left = optimize(expr.left(), program);
+        auto const right = optimize(expr.right(), program);
+        auto const leftLiteral = literal(*left);
+        auto const rightLiteral = literal(*right);
+        if (leftLiteral && rightLiteral) {
+            if (auto const value = fold(expr.operatr(), leftLiteral->value(), rightLiteral->value())) {
+                return program.make<LiteralExpr>(*value);
+            }
+        }
+
+        // Once a string is involved + concatenates, so (e + "a") + "b" is e + "ab".
+        if (expr.operatr().tokenType() == TokenType::PLUS && rightLiteral && rightLiteral->value().isString() && left->kind() == ExprKind::BINARY) {
+            auto const& inner = static_cast<BinaryExpr const&>(*left);
+            auto const innerRight = literal(inner.right());
+            if (inner.operatr().tokenType() == TokenType::PLUS && innerRight && innerRight->value().isString()) {
+                auto const joined = program.make<LiteralExpr>(Object(innerRight->value().toString() + rightLiteral->value().toString()));
+                return program.make<BinaryExpr>(&inner.left(), inner.operatr(), joined);
+            }
+        }
+
+        if (left == &expr.left() && right == &expr.right()) return &expr;
+        return program.make<BinaryExpr>(left, expr.operatr(), right);
+    }
+    Expr const* optimizeGroupingExpr(GroupingExpr const& expr, Program& program) {
+        return optimize(expr.expression(), program);
+    }
+    Expr const* optimizeLiteralExpr(LiteralExpr const& expr, Program&) {
+        return &expr;
+    }
+    Expr const* optimizeUnaryExpr(UnaryExpr const& expr, Program& program) {
+        auto const right = optimize(expr.right(), program);
+        if (auto const operand = literal(*right)) {
+            switch (expr.operatr().tokenType()) {
+            case TokenType::BANG:
+                return program.make<LiteralExpr>(Object(!isTruthy(operand->value())));
+            case TokenType::MINUS:
+                if (operand->value().isDouble()) return program.make<LiteralExpr>(Object(-static_cast<double>(operand->value())));
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (right == &expr.right()) return &expr;
+        return program.make<UnaryExpr>(expr.operatr(), right);
+    }
+    Expr const* optimizeVariableExpr(VariableExpr const& expr, Program&) {
+        return &expr;
+    }
+    Expr const* optimizeAssignExpr(AssignExpr const& expr, Program& program) {
+        auto const value = optimize(expr.value(), program);
+        if (value->kind() == ExprKind::BINARY) {
+            auto const& binary = static_cast<BinaryExpr const&>(*value);
+            auto const constant = literal(binary.right());
+            if (isArithmetic(binary.operatr().tokenType()) && isVariable(binary.left(), expr.name(), expr.slot()) && constant && constant->value().isDouble()) {
+                auto const assign = program.make<CompoundAssignExpr>(expr.name(), binary.operatr(), static_cast<double>(constant->value()));
+                assign->resolveSlot(expr.slot());
+                return assign;
+            }
+        }
+
+        if (value == &expr.value()) return &expr;
+        auto const assign = program.make<AssignExpr>(expr.name(), value);
+        assign->resolveSlot(expr.slot());
+        return assign;
+    }
+    Expr const* optimizeLogicalExpr(LogicalExpr const& expr, Program& program) {
+        auto const left = optimize(expr.left(), program);
+        auto const right = optimize(expr.right(), program);
+        if (auto const operand = literal(*left)) {
+            auto const isDecided = expr.operatr().tokenType() == TokenType::OR ? isTruthy(operand->value()) : !isTruthy(operand->value());
+            return isDecided ? left : right;
+        }
+
+        if (left == &expr.left() && right == &expr.right()) return &expr;
+        return program.make<LogicalExpr>(left, expr.operatr(), right);
+    }
+    Expr const* optimizeCallExpr(CallExpr const& expr, Program& program) {
+        auto const callee = optimize(expr.callee(), program);
+        auto arguments = std::vector<Expr const*>();
+        arguments.reserve(expr.arguments().size());
+        std::ranges::transform(expr.arguments(), std::back_inserter(arguments), [&](Expr const* argument) { return optimize(*argument, program); });
+
+        if (callee == &expr.callee() && arguments == expr.arguments()) return &expr;
+        return program.make<CallExpr>(callee, expr.paren(), arguments);
+    }
+    Expr const* optimizeGetExpr(GetExpr const& expr, Program& program) {
+        auto const object = optimize(expr.object(), program);
+        if (object == &expr.object()) return &expr;
+        return program.make<GetExpr>(object, expr.name());
+    }
+    Expr const* optimizeSetExpr(SetExpr const& expr, Program& program) {
+        auto const object = optimize(expr.object(), program);
+        auto const value = optimize(expr.value(), program);
+        if (object == &expr.object() && value == &expr.value()) return &expr;
+        return program.make<SetExpr>(object, expr.name(), value);
+    }
+    Expr const* optimizeThisExpr(ThisExpr const& expr, Program&) {
+        return &expr;
+    }
+    Expr const* optimizeSuperExpr(SuperExpr const& expr, Program&) {
+        return &expr;
+    }
+    Expr const* optimizeCompoundAssignExpr(CompoundAssignExpr const& expr, Program&) {
+        return &expr;
+    }
+
+    // The fused loop for a while loop that compares a variable and steps it
+    // last thing in its body, as a for loop does, or nullptr. A declaration
+    // left alone in the body keeps a block of its own, so that it is scoped
+    // to one iteration as it was inside the original body.
+    CountedLoopStmt const* countedLoop(Expr const* condition, Stmt const* body, Program& program) {
+        if (condition->kind() != ExprKind::BINARY || body->kind() != StmtKind::BLOCK) return nullptr;
+        auto const& comparison = static_cast<BinaryExpr const&>(*condition);
+        auto const& statements = static_cast<BlockStmt const&>(*body).statements();
+        if (!isComparison(comparison.operatr().tokenType()) || statements.size() != 2 || statements[1]->kind() != StmtKind::EXPRESSION) return nullptr;
+        auto const& step = static_cast<ExpressionStmt const&>(*statements[1]).expression();
+        if (step.kind() != ExprKind::COMPOUND_ASSIGN) return nullptr;
+        auto const& increment = static_cast<CompoundAssignExpr const&>(step);
+        if (!isVariable(comparison.left(), increment.name(), increment.slot())) return nullptr;
+        auto const declares = statements[0]->kind() == StmtKind::VAR || statements[0]->kind() == StmtKind::FUNCTION || statements[0]->kind() == StmtKind::CLASS;
+        auto const loopBody = declares ? program.make<BlockStmt>(std::vector{ statements[0] }) : statements[0];
+        return program.make<CountedLoopStmt>(&comparison, loopBody, &increment);
+    }
+
+    // Optimize functions of concrete statements:
+    Stmt const* optimizeExpressionStmt(ExpressionStmt const& stmt, Program& program) {
+        auto const expression = optimize(stmt.expression(), program);
+        if (expression == &stmt.expression()) return &stmt;
+        return program.make<ExpressionStmt>(expression);
+    }
+    Stmt const* optimizePrintStmt(PrintStmt const& stmt, Program& program) {
+        auto const expression = optimize(stmt.expression(), program);
+        if (expression == &stmt.expression()) return &stmt;
+        return program.make<PrintStmt>(expression);
+    }
+    Stmt const* optimizeVarStmt(VarStmt const& stmt, Program& program) {
+        auto const initializer = stmt.initializer() ? optimize(*stmt.initializer(), program) : nullptr;
+        if (initializer == stmt.initializer()) return &stmt;
+        auto const var = program.make<VarStmt>(stmt.name(), initializer);
+        var->resolveSlot(stmt.slot());
+        return var;
+    }
+    Stmt const* optimizeBlockStmt(BlockStmt const& stmt, Program& program) {
+        auto const statements = optimize(stmt.statements(), program);
+        if (statements == stmt.statements()) return &stmt;
+        return program.make<BlockStmt>(statements);
+    }
+    // Literal conditions are decided by their truthiness, as both engines
+    // decide them at run time.
+    Stmt const* optimizeIfStmt(IfStmt const& stmt, Program& program) {
+        auto const condition = optimize(stmt.condition(), program);
+        if (auto const value = literal(*condition)) {
+            if (isTruthy(value->value())) return optimize(stmt.thenBranch(), program);
+            return stmt.elseBranch() ? optimize(*stmt.elseBranch(), program) : nullptr;
+        }
+
+        auto const thenBranch = orEmpty(optimize(stmt.thenBranch(), program), program);
+        auto const elseBranch = stmt.elseBranch() ? orEmpty(optimize(*stmt.elseBranch(), program), program) : nullptr;
+        if (condition == &stmt.condition() && thenBranch == &stmt.thenBranch() && elseBranch == stmt.elseBranch()) return &stmt;
+        return program.make<IfStmt>(condition, thenBranch, elseBranch);
+    }
+    Stmt const* optimizeWhileStmt(WhileStmt const& stmt, Program& program) {
+        auto const condition = optimize(stmt.condition(), program);
+        if (auto const value = literal(*condition); value && !isTruthy(value->value())) return nullptr;
+
+        auto const body = orEmpty(optimize(stmt.body(), program), program);
+        if (auto const loop = countedLoop(condition, body, program)) return loop;
+        if (condition == &stmt.condition() && body == &stmt.body()) return &stmt;
+        return program.make<WhileStmt>(condition, body);
+    }
+    Stmt const* optimizeFunctionStmt(FunctionStmt const& stmt, Program& program) {
+        auto const statements = optimize(stmt.body().statements(), program);
+        if (statements == stmt.body().statements()) return &stmt;
+        auto const function = program.make<FunctionStmt>(stmt.name(), stmt.parameters(), BlockStmt(statements));
+        function->resolveSlot(stmt.slot());
+        function->resolveLayout(stmt.layout());
+        return function;
+    }
+    Stmt const* optimizeReturnStmt(ReturnStmt const& stmt, Program& program) {
+        auto const value = stmt.value() ? optimize(*stmt.value(), program) : nullptr;
+        if (value == stmt.value()) return &stmt;
+        return program.make<ReturnStmt>(stmt.keyword(), value);
+    }
+    Stmt const* optimizeClassStmt(ClassStmt const& stmt, Program& program) {
+        auto methods = std::vector<FunctionStmt const*>();
+        methods.reserve(stmt.methods().size());
+        std::ranges::transform(stmt.methods(), std::back_inserter(methods), [&](FunctionStmt const* method) {
+            return static_cast<FunctionStmt const*>(optimizeFunctionStmt(*method, program));
+        });
+
+        if (methods == stmt.methods()) return &stmt;
+        auto const klass = program.make<ClassStmt>(stmt.name(), stmt.superclass(), methods);
+        klass->resolveSlot(stmt.slot());
+        klass->resolveSuperSlot(stmt.superSlot());
+        return klass;
+    }
+    Stmt const* optimizeCountedLoopStmt(CountedLoopStmt const& stmt, Program&) {
+        return &stmt;
+    }
+
+    // Implementation of generic optimize functions
+    Expr const* optimize(Expr const& expr, Program& program) {
+
+        static constexpr auto dispatcher = Dispatcher<Expr const*, Expr const&, Program&>::create<
+            optimizeBinaryExpr,
+            optimizeGroupingExpr,
+            optimizeLiteralExpr,
+            optimizeUnaryExpr,
+            optimizeVariableExpr,
+            optimizeAssignExpr,
+            optimizeLogicalExpr,
+            optimizeCallExpr,
+            optimizeGetExpr,
+            optimizeSetExpr,
+            optimizeThisExpr,
+            optimizeSuperExpr,
+            optimizeCompoundAssignExpr
+        >("expression optimizer");
+
+        return dispatcher.dispatch(expr, program);
+    }
+
+    Stmt const* optimize(Stmt const& stmt, Program& program) {
+
+        static constexpr auto dispatcher = Dispatcher<Stmt const*, Stmt const&, Program&>::create<
+            optimizeExpressionStmt,
+            optimizePrintStmt,
+            optimizeVarStmt,
+            optimizeBlockStmt,
+            optimizeIfStmt,
+            optimizeWhileStmt,
+            optimizeFunctionStmt,
+            optimizeReturnStmt,
+            optimizeClassStmt,
+            optimizeCountedLoopStmt
+        >("statement optimizer");
+
+        return dispatcher.dispatch(stmt, program);
+    }
+
+    std::vector<Stmt const*> optimize(std::vector<Stmt const*> const& statements, Program& program) {
+        auto optimized = std::vector<Stmt const*>();
+        optimized.reserve(statements.size());
+        for (auto const* statement : statements) {
+            if (auto const replacement = optimize(*statement, program)) optimized.push_back(replacement);
+        }
+        return optimized;
+    }
+
+}
+
+void optimize(Program& program) {
+    program.replaceStatements(optimize(program.statements(), program));
+}
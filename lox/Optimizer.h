@@ -0,0 +1,11 @@
+#pragma once
+
+class Program;
+
+// Simplifies a resolved program before it runs: operators whose operands are
+// literals are folded, branches and loops that a literal condition rules out
+// are dropped and string literals concatenated in a row are joined. Counted
+// loops and x = x op k are fused into nodes of their own. Nodes that change
+// are rebuilt in the program with the slots the resolver gave the originals,
+// and replace them in its statements.
+void optimize(Program& program);
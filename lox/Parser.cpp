@@ -1,9 +1,13 @@
 #include "Parser.h"
+#include "Scanner.h"
 #include "Token.h"
 #include "TokenType.h"
 #include "Expr.h"
 #include "Stmt.h"
+#include "Program.h"
 #include "Lox.h"
+#include <cstddef>
+#include <utility>
 
 namespace {
     struct ParseError {
@@ -13,8 +17,9 @@ namespace {
 
     class Parser {
     public:
-        Parser(std::vector<Token> const& tokens) : mTokens(tokens) {}
-        std::vector<Stmt const*> parse();
+        explicit Parser(Scanner& scanner) : mScanner(&scanner), mCurrent(nextToken()), mPrevious(mCurrent) {}
+        explicit Parser(std::vector<Token> const& tokens) : mTokens(&tokens), mCurrent(nextToken()), mPrevious(mCurrent) {}
+        Program parse();
 
     private:
         Stmt const* declaration();
@@ -48,6 +53,7 @@ namespace {
         bool isAtEnd() const;
         Token const& peek() const;
         Token const& previous() const;
+        Token nextToken();
 
         template <TokenType T>
         bool check() const {
@@ -75,17 +81,23 @@ namespace {
             throw ParseError(peek(), message);
         }
 
-        std::vector<Token> mTokens;
-        int mCurrent = 0;
+        // Tokens come from the scanner as the parser gets to them, or from a
+        // vector scanned beforehand. Only the current and the previous token
+        // are kept.
+        Scanner* mScanner = nullptr;
+        std::vector<Token> const* mTokens = nullptr;
+        std::size_t mNext = 0;
+        Token mCurrent;
+        Token mPrevious;
+        Program mProgram;
     };
 }
 
-std::vector<Stmt const*> Parser::parse() {
-    auto statements = std::vector<Stmt const*>();
+Program Parser::parse() {
     while (!isAtEnd()) {
-        statements.push_back(declaration());
+        mProgram.add(declaration());
     }
-    return statements;
+    return std::move(mProgram);
 }
 
 Stmt const* Parser::declaration() {
@@ -106,7 +118,7 @@ ClassStmt const* Parser::classDeclaration() {
 
     const auto superclass = match<TokenType::LESS>() ? [&] {
         consume<TokenType::IDENTIFIER>("Expect superclass name.");
-        return new VariableExpr(previous());
+        return mProgram.make<VariableExpr>(previous());
     }() : nullptr;
 
     consume<TokenType::LEFT_BRACE>("Expect '{' before class body.");
@@ -118,14 +130,14 @@ ClassStmt const* Parser::classDeclaration() {
 
     consume<TokenType::RIGHT_BRACE>("Expect '}' after class body.");
 
-    return new ClassStmt(name, superclass, methods);
+    return mProgram.make<ClassStmt>(name, superclass, methods);
 }
 
 VarStmt const* Parser::varDeclaration() {
-    auto const& name = consume<TokenType::IDENTIFIER>("Expect variable name");
-    auto const initializer = match<TokenType::EQUAL>() ? expression() : new LiteralExpr({});
+    auto const name = consume<TokenType::IDENTIFIER>("Expect variable name");
+    auto const initializer = match<TokenType::EQUAL>() ? expression() : mProgram.make<LiteralExpr>(Object());
     consume<TokenType::SEMICOLON>("Expect ';' after variable declaration.");
-    return new VarStmt(name, initializer);
+    return mProgram.make<VarStmt>(name, initializer);
 }
 
 Stmt const* Parser::statement() {
@@ -144,13 +156,13 @@ IfStmt const* Parser::ifStatement() {
     consume<TokenType::RIGHT_PAREN>("Expect ')' after 'if'.");
     auto const thenBranch = statement();
     auto const elseBranch = match<TokenType::ELSE>() ? statement() : nullptr;
-    return new IfStmt(condition, thenBranch, elseBranch);
+    return mProgram.make<IfStmt>(condition, thenBranch, elseBranch);
 }
 
 PrintStmt const* Parser::printStatement() {
     auto const value = expression();
     consume<TokenType::SEMICOLON>("Expect ';' after value.");
-    return new PrintStmt(value);
+    return mProgram.make<PrintStmt>(value);
 }
 
 WhileStmt const* Parser::whileStatement() {
@@ -158,7 +170,7 @@ WhileStmt const* Parser::whileStatement() {
     auto const condition = expression();
     consume<TokenType::RIGHT_PAREN>("Expect ')' after condition.");
     auto const body = statement();
-    return new WhileStmt(condition, body);
+    return mProgram.make<WhileStmt>(condition, body);
 }
 
 ReturnStmt const* Parser::returnStatement() {
@@ -168,7 +180,7 @@ ReturnStmt const* Parser::returnStatement() {
         value = expression();
     }
     consume<TokenType::SEMICOLON>("Expect ';' after return value.");
-    return new ReturnStmt(keyword, value);
+    return mProgram.make<ReturnStmt>(keyword, value);
 }
 
 Stmt const* Parser::forStatement() {
@@ -185,7 +197,7 @@ Stmt const* Parser::forStatement() {
         initializer = expressionStatement();
     }
 
-    auto const condition = check<TokenType::SEMICOLON>() ? new LiteralExpr(true) : expression();
+    auto const condition = check<TokenType::SEMICOLON>() ? mProgram.make<LiteralExpr>(true) : expression();
     consume<TokenType::SEMICOLON>("Expect ';' after condition.");
 
     auto const increment = check<TokenType::RIGHT_PAREN>() ? nullptr: expression();
@@ -194,13 +206,13 @@ Stmt const* Parser::forStatement() {
     auto body = statement();
 
     if (increment) {
-        body = new BlockStmt({ body, new ExpressionStmt(increment) });
+        body = mProgram.make<BlockStmt>(std::vector<Stmt const*>{ body, mProgram.make<ExpressionStmt>(increment) });
     }
 
-    body = new WhileStmt(condition, body);
+    body = mProgram.make<WhileStmt>(condition, body);
     
     if (initializer) {
-        body = new BlockStmt({ initializer, body });
+        body = mProgram.make<BlockStmt>(std::vector<Stmt const*>{ initializer, body });
     }
 
     return body;
@@ -214,13 +226,13 @@ BlockStmt const* Parser::blockStatement() {
     }
     
     consume<TokenType::RIGHT_BRACE>("Expect '}' after block.");
-    return new BlockStmt(statements);
+    return mProgram.make<BlockStmt>(statements);
 }
 
 ExpressionStmt const* Parser::expressionStatement() {
     auto const expr = expression();
     consume<TokenType::SEMICOLON>("Expect ';' after expression.");
-    return new ExpressionStmt(expr);
+    return mProgram.make<ExpressionStmt>(expr);
 }
 
 FunctionStmt const* Parser::function(std::string const& kind) {
@@ -238,7 +250,8 @@ FunctionStmt const* Parser::function(std::string const& kind) {
     consume<TokenType::RIGHT_PAREN>("Expect ')' after " + kind + " name.");
     consume<TokenType::LEFT_BRACE>("Expect '{' before " + kind + " body.");
     auto const body = blockStatement();
-    return new FunctionStmt(name, parameters, *body);
+    mProgram.markDeclaresFunctions();
+    return mProgram.make<FunctionStmt>(name, parameters, *body);
 }
 
 Expr const* Parser::expression() {
@@ -254,10 +267,10 @@ Expr const* Parser::assignment() {
 
         if (auto const variableExpr = dynamic_cast<VariableExpr const*>(expr)) {
             auto const name = variableExpr->name();
-            return new AssignExpr(name, value);
+            return mProgram.make<AssignExpr>(name, value);
         }
         else if (auto const getExpr = dynamic_cast<GetExpr const*>(expr)) {
-            return new SetExpr(&getExpr->object(), getExpr->name(), value);
+            return mProgram.make<SetExpr>(&getExpr->object(), getExpr->name(), value);
         }
 
         throw ParseError(equals, "Invalid assignment target.");
@@ -272,7 +285,7 @@ Expr const* Parser::oor() {
     while (match<TokenType::OR>()) {
         auto const operatr = previous();
         auto const right = aand();
-        expr = new LogicalExpr(expr, operatr, right);
+        expr = mProgram.make<LogicalExpr>(expr, operatr, right);
     }
 
     return expr;
@@ -283,7 +296,7 @@ Expr const* Parser::aand() {
     while (match<TokenType::AND>()) {
         auto const operatr = previous();
         auto const right = equality();
-        expr = new LogicalExpr(expr, operatr, right);
+        expr = mProgram.make<LogicalExpr>(expr, operatr, right);
     }
 
     return expr;
@@ -294,7 +307,7 @@ Expr const* Parser::equality() {
     while (match<TokenType::BANG_EQUAL, TokenType::EQUAL_EQUAL>()) {
         auto const operatr = previous();
         auto const right = comparison();
-        expr = new BinaryExpr(expr, operatr, right);
+        expr = mProgram.make<BinaryExpr>(expr, operatr, right);
     }
 
     return expr;
@@ -306,7 +319,7 @@ Expr const* Parser::comparison() {
     while (match<TokenType::GREATER, TokenType::GREATER_EQUAL, TokenType::LESS, TokenType::LESS_EQUAL>()) {
         auto const operatr = previous();
         auto const right = term();
-        expr = new BinaryExpr(expr, operatr, right);;
+        expr = mProgram.make<BinaryExpr>(expr, operatr, right);;
     }
 
     return expr;
@@ -318,7 +331,7 @@ Expr const* Parser::term() {
     while (match<TokenType::MINUS, TokenType::PLUS>()) {
         auto const operatr = previous();
         auto const right = factor();
-        expr = new BinaryExpr(expr, operatr, right);;
+        expr = mProgram.make<BinaryExpr>(expr, operatr, right);;
     }
 
     return expr;
@@ -330,7 +343,7 @@ Expr const* Parser::factor() {
     while (match<TokenType::SLASH, TokenType::STAR>()) {
         auto const operatr = previous();
         auto const right = unary();
-        expr = new BinaryExpr(expr, operatr, right);;
+        expr = mProgram.make<BinaryExpr>(expr, operatr, right);;
     }
 
     return expr;
@@ -340,7 +353,7 @@ Expr const* Parser::unary() {
     if (match<TokenType::BANG, TokenType::MINUS>()) {
         auto const operatr = previous();
         auto const right = unary();
-        return new UnaryExpr(operatr, right);
+        return mProgram.make<UnaryExpr>(operatr, right);
     }
 
     return call();
@@ -355,7 +368,7 @@ Expr const* Parser::call() {
         }
         else if (match<TokenType::DOT>()) {
             auto const name = consume<TokenType::IDENTIFIER>("Expect property name after '.'.");
-            expr = new GetExpr(expr, name);
+            expr = mProgram.make<GetExpr>(expr, name);
         }
         else {
             break;
@@ -379,38 +392,38 @@ Expr const* Parser::finishCall(Expr const* callee) {
 
     auto const paren = consume<TokenType::RIGHT_PAREN>("Expect ')' after arguments.");
 
-    return new CallExpr(callee, paren, arguments);
+    return mProgram.make<CallExpr>(callee, paren, arguments);
 
 }   
 
 Expr const* Parser::primary() {
-    if (match<TokenType::FALSE>()) return new LiteralExpr(false);
-    if (match<TokenType::TRUE>()) return new LiteralExpr(true);
-    if (match<TokenType::NIL>()) return new LiteralExpr({});
+    if (match<TokenType::FALSE>()) return mProgram.make<LiteralExpr>(false);
+    if (match<TokenType::TRUE>()) return mProgram.make<LiteralExpr>(true);
+    if (match<TokenType::NIL>()) return mProgram.make<LiteralExpr>(Object());
     
     if (match<TokenType::SUPER>()) {
         auto const keyword = previous();
         consume<TokenType::DOT>("Expect '.' after super.");
         auto const method = consume<TokenType::IDENTIFIER>("Expect superclass method name.");
-        return new SuperExpr(keyword, method);
+        return mProgram.make<SuperExpr>(keyword, method);
     }
 
     if (match<TokenType::NUMBER, TokenType::STRING>()) {
-        return new LiteralExpr(previous().literal());
+        return mProgram.make<LiteralExpr>(previous().literal());
     }
 
     if (match<TokenType::THIS>()) {
-        return new ThisExpr(previous());
+        return mProgram.make<ThisExpr>(previous());
     }
 
     if (match<TokenType::IDENTIFIER>()) {
-        return new VariableExpr(previous());
+        return mProgram.make<VariableExpr>(previous());
     }
 
     if (match<TokenType::LEFT_PAREN>()) {
         auto const expr = expression();
         consume<TokenType::RIGHT_PAREN>("Expect ')' after expression.");
-        return new GroupingExpr(expr);
+        return mProgram.make<GroupingExpr>(expr);
     }
 
     throw ParseError(peek(), "Expect expression.");
@@ -438,7 +451,7 @@ void Parser::synchronise() {
 }
 
 Token const& Parser::advance() {
-    if (!isAtEnd()) mCurrent++;
+    if (!isAtEnd()) mPrevious = std::exchange(mCurrent, nextToken());
     return previous();
 }
 
@@ -447,14 +460,32 @@ bool Parser::isAtEnd() const{
 }
 
 Token const& Parser::peek() const {
-    return mTokens.at(mCurrent);
+    return mCurrent;
 }
 
 Token const& Parser::previous() const {
-    return mTokens.at(mCurrent - 1);
+    return mPrevious;
+}
+
+Token Parser::nextToken() {
+    if (mScanner) return mScanner->next();
+    return mTokens->at(mNext++);
+}
+
+Program parse(Source source) {
+    try {
+        auto scanner = Scanner(source.text());
+        auto program = Parser(scanner).parse();
+        program.keepSource(std::move(source));
+        return program;
+    }
+    catch (ParseError const& error) {
+        Lox::error(error.token, error.message);
+        return {};
+    }
 }
 
-std::vector<Stmt const*> parse(std::vector<Token> const& tokens) {
+Program parse(std::vector<Token> const& tokens) {
     try {
         auto parser = Parser(tokens);
         return parser.parse();
@@ -1,8 +1,12 @@
 #pragma once
 
+#include "Program.h"
+#include "Source.h"
 #include <vector>
 
-class Stmt;
 class Token;
 
-std::vector<Stmt const*> parse(std::vector<Token> const& tokens);
\ No newline at end of file
+// Parses source, scanning it as the parser goes, and keeps it with the program.
+Program parse(Source source);
+// The tree refers to the tokens' source: see Program::keepSource.
+Program parse(std::vector<Token> const& tokens);
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "Program.h"
+#include <algorithm>
+#include <cstdint>
+#include <ranges>
+
+Program::Program(Program&& other) noexcept
+    : mBlocks(std::move(other.mBlocks))
+    , mNext(std::exchange(other.mNext, nullptr))
+    , mEnd(std::exchange(other.mEnd, nullptr))
+    , mBytesAllocated(std::exchange(other.mBytesAllocated, 0))
+    , mDestructors(std::move(other.mDestructors))
+    , mStatements(std::move(other.mStatements))
+    , mDeclaresFunctions(std::exchange(other.mDeclaresFunctions, false))
+    , mSource(std::move(other.mSource)) {
+}
+
+Program& Program::operator=(Program&& other) noexcept {
+    if (this != &other) {
+        release();
+        mBlocks = std::move(other.mBlocks);
+        mNext = std::exchange(other.mNext, nullptr);
+        mEnd = std::exchange(other.mEnd, nullptr);
+        mBytesAllocated = std::exchange(other.mBytesAllocated, 0);
+        mDestructors = std::move(other.mDestructors);
+        mStatements = std::move(other.mStatements);
+        mDeclaresFunctions = std::exchange(other.mDeclaresFunctions, false);
+        mSource = std::move(other.mSource);
+    }
+    return *this;
+}
+
+Program::~Program() {
+    release();
+}
+
+void Program::release() {
+    // Nodes only point at their children, so tearing them down in reverse
+    // order of construction is just the usual convention, not a requirement.
+    for (auto const& destructor : mDestructors | std::views::reverse) {
+        destructor.destroy(destructor.node);
+    }
+    mDestructors.clear();
+    mStatements.clear();
+    mBlocks.clear();
+    mNext = mEnd = nullptr;
+}
+
+void* Program::allocate(std::size_t size, std::size_t alignment) {
+    auto const address = reinterpret_cast<std::uintptr_t>(mNext);
+    auto const padding = (alignment - address % alignment) % alignment;
+    if (!mNext || padding + size > static_cast<std::size_t>(mEnd - mNext)) {
+        auto const length = std::max(blockSize, size + alignment);
+        mBlocks.push_back(std::make_unique_for_overwrite<std::byte[]>(length));
+        mNext = mBlocks.back().get();
+        mEnd = mNext + length;
+        return allocate(size, alignment);
+    }
+    auto const node = mNext + padding;
+    mNext = node + size;
+    mBytesAllocated += size;
+    return node;
+}
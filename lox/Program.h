@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Source.h"
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class Stmt;
+
+// The syntax tree of one parsed source text. Nodes are bump-allocated from
+// large blocks owned by the program, so a tree is laid out contiguously in
+// the order it was parsed and is freed in one go when the program is
+// destroyed. Everything that refers to a node, including the closures the
+// interpreter creates for function declarations, must not outlive it.
+//
+// The tokens in the tree are views into the source text, which a program that
+// outlives its caller's copy of the source has to keep.
+class Program {
+public:
+    static constexpr std::size_t blockSize = 64 * 1024;
+
+    Program() = default;
+    Program(Program&& other) noexcept;
+    Program& operator=(Program&& other) noexcept;
+    Program(Program const&) = delete;
+    Program& operator=(Program const&) = delete;
+    ~Program();
+
+    template <class T, class... Args>
+    T const* make(Args&&... args) {
+        auto const node = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            mDestructors.push_back({ node, [](void const* p) { static_cast<T const*>(p)->~T(); } });
+        }
+        return node;
+    }
+
+    void add(Stmt const* statement) { mStatements.push_back(statement); }
+    std::vector<Stmt const*> const& statements() const { return mStatements; }
+    // For passes that rewrite the tree, with nodes made in this program.
+    void replaceStatements(std::vector<Stmt const*> statements) { mStatements = std::move(statements); }
+
+    // Whether the program declares functions or classes, whose closures keep
+    // referring to their declarations after the program has run.
+    bool declaresFunctions() const { return mDeclaresFunctions; }
+    void markDeclaresFunctions() { mDeclaresFunctions = true; }
+
+    std::size_t bytesAllocated() const { return mBytesAllocated; }
+
+    // Takes over the source the program was parsed from.
+    void keepSource(Source source) { mSource = std::move(source); }
+    std::string_view source() const { return mSource.text(); }
+
+private:
+    struct Destructor {
+        void const* node;
+        void (*destroy)(void const*);
+    };
+
+    void* allocate(std::size_t size, std::size_t alignment);
+    void release();
+
+    std::vector<std::unique_ptr<std::byte[]>> mBlocks;
+    std::byte* mNext = nullptr;
+    std::byte* mEnd = nullptr;
+    std::size_t mBytesAllocated = 0;
+    std::vector<Destructor> mDestructors;
+    std::vector<Stmt const*> mStatements;
+    bool mDeclaresFunctions = false;
+    Source mSource;
+};
@@ -3,6 +3,8 @@
 #include "Expr.h"
 #include "Stmt.h"
 #include "Lox.h"
+#include <algorithm>
+#include <functional>
 #include <vector>
 #include <string>
 #include <unordered_map>
@@ -17,10 +19,40 @@ namespace {
         NONE, CLASS, SUBCLASS
     };
 
-    using Scopes = std::vector<std::unordered_map<std::string, bool>>;
+    // Sets the place of a declaration or a use once the resolver knows it.
+    using Reference = std::function<void(VariableSlot const&)>;
+
+    template <class Node>
+    Reference slotOf(Node const& node) {
+        return [&node](VariableSlot const& slot) { node.resolveSlot(slot); };
+    }
+
+    // Whether a local needs a cell is only known once its scope ends, as a
+    // closure declared later in the scope may still capture it. Until then the
+    // declaration and the uses in the declaring function are collected.
+    struct Variable {
+        bool defined;
+        int slot;
+        int cell = -1;
+        std::vector<Reference> references = {};
+    };
+
+    struct Scope {
+        std::unordered_map<std::string_view, Variable> variables; // keys view the declarations' tokens
+        std::size_t function;   // index of the declaring function in ResolverContext::functions
+        int firstSlot;          // slots from here on are free again when the scope ends
+    };
+
+    struct FunctionScope {
+        FrameLayout layout;
+        int nextSlot = 0;
+    };
 
     struct ResolverContext {
-        Scopes scopes;
+        std::vector<Scope> scopes;
+        // Functions being resolved, innermost last. The first one stands for
+        // the top level, whose blocks have locals too.
+        std::vector<FunctionScope> functions = std::vector<FunctionScope>(1);
         FunctionType currentFunction = FunctionType::NONE;
         ClassType currentClass = ClassType::NONE;
     };
@@ -28,39 +60,106 @@ namespace {
     void resolve(Stmt const& stmt, ResolverContext& context);
     void resolve(Expr const& expr, ResolverContext& context);
 
-    void beginScope(Scopes& scopes) {
-        scopes.emplace_back();
+    void beginScope(ResolverContext& context) {
+        context.scopes.push_back({ {}, context.functions.size() - 1, context.functions.back().nextSlot });
+    }
+    void endScope(ResolverContext& context) {
+        auto const& scope = context.scopes.back();
+        for (auto const& [name, variable] : scope.variables) {
+            auto const slot = variable.cell < 0
+                ? VariableSlot{ VariableSlot::Kind::LOCAL, variable.slot }
+                : VariableSlot{ VariableSlot::Kind::CELL, variable.cell };
+            for (auto const& reference : variable.references) {
+                reference(slot);
+            }
+        }
+        context.functions[scope.function].nextSlot = scope.firstSlot;
+        context.scopes.pop_back();
+    }
+    Variable* declare(std::string_view name, ResolverContext& context) {
+        if (context.scopes.empty()) return nullptr;
+        auto& function = context.functions.back();
+        auto const [it, inserted] = context.scopes.back().variables.try_emplace(name, Variable{ false, function.nextSlot });
+        if (inserted) {
+            function.layout.slotCount = std::max(function.layout.slotCount, ++function.nextSlot);
+        }
+        return &it->second;
     }
-    void endScope(Scopes& scopes) {
-        scopes.pop_back();
+    Variable* declare(Token const& name, ResolverContext& context) {
+        if (!context.scopes.empty() && context.scopes.back().variables.contains(name.lexeme())) {
+            Lox::error(name, "Already a variable with this name in this scope.");
+        }
+        return declare(name.lexeme(), context);
+    }
+    void declare(Token const& name, Reference const& reference, ResolverContext& context) {
+        if (auto const variable = declare(name, context)) variable->references.push_back(reference);
+        else reference({});
     }
-    void declare(Token const& name, Scopes& scopes) {
-        if (scopes.empty()) return;
-        if (scopes.back().contains(name.lexeme())) Lox::error(name, "Already a variable with this name in this scope.");
-        scopes.back()[name.lexeme()] = false;
+    void define(std::string_view name, ResolverContext& context) {
+        if (context.scopes.empty()) return;
+        context.scopes.back().variables.at(name).defined = true;
     }
-    void define(Token const& name, Scopes& scopes) {
-        if (scopes.empty()) return;
-        scopes.back()[name.lexeme()] = true;
+    void define(Token const& name, ResolverContext& context) {
+        define(name.lexeme(), context);
     }
-    void resolveLocal(Expr const& expr, Token const& name, ResolverContext& context) {
-        for (auto i = static_cast<int>(context.scopes.size()) - 1; i >= 0; --i) {
-            if (context.scopes[i].contains(name.lexeme())) {
-                Lox::locals[&expr] = static_cast<int>(context.scopes.size()) - 1 - i;
+    int addCapture(std::vector<Capture>& captures, Capture const& capture) {
+        auto const it = std::ranges::find_if(captures, [&](Capture const& existing) {
+            return existing.fromCell == capture.fromCell && existing.index == capture.index;
+        });
+        if (it != captures.end()) return static_cast<int>(it - captures.begin());
+        captures.push_back(capture);
+        return static_cast<int>(captures.size()) - 1;
+    }
+    // Boxes a variable of an enclosing function and threads it through every
+    // function in between. Returns its upvalue index in the innermost one.
+    int capture(Variable& variable, std::size_t declaringFunction, ResolverContext& context) {
+        if (variable.cell < 0) {
+            variable.cell = context.functions[declaringFunction].layout.cellCount++;
+        }
+        auto capture = Capture{ true, variable.cell };
+        for (auto i = declaringFunction + 1; i != context.functions.size(); ++i) {
+            capture = Capture{ false, addCapture(context.functions[i].layout.captures, capture) };
+        }
+        return capture.index;
+    }
+    void resolveLocal(std::string_view name, Reference const& reference, ResolverContext& context) {
+        for (auto scope = context.scopes.rbegin(); scope != context.scopes.rend(); ++scope) {
+            if (auto const it = scope->variables.find(name); it != scope->variables.end()) {
+                if (scope->function == context.functions.size() - 1) {
+                    it->second.references.push_back(reference);
+                }
+                else {
+                    reference({ VariableSlot::Kind::UPVALUE, capture(it->second, scope->function, context) });
+                }
                 return;
             }
         }
+        reference({});
     }
     void resolveFunction(FunctionStmt const& stmt, FunctionType type, ResolverContext& context) {
         auto const enclosingFunction = std::exchange(context.currentFunction, type);
 
-        beginScope(context.scopes);
+        context.functions.emplace_back();
+        beginScope(context);
+        // Methods receive 'this' in the first slot, ahead of the parameters.
+        auto parameters = std::vector<Variable const*>();
+        if (type == FunctionType::METHOD || type == FunctionType::INITIALIZER) {
+            parameters.push_back(declare("this", context));
+            define("this", context);
+        }
         for (Token const& param : stmt.parameters()) {
-            declare(param, context.scopes);
-            define(param, context.scopes);
+            parameters.push_back(declare(param, context));
+            define(param, context);
         }
         resolve(stmt.body(), context);
-        endScope(context.scopes);
+
+        auto& layout = context.functions.back().layout;
+        for (auto const* parameter : parameters) {
+            if (parameter->cell >= 0) layout.capturedParameters.push_back({ parameter->slot, parameter->cell });
+        }
+        endScope(context);
+        stmt.resolveLayout(layout);
+        context.functions.pop_back();
 
         context.currentFunction = enclosingFunction;
     }
@@ -69,22 +168,22 @@ namespace {
 
     // Statements:
     void resolveVarStmt(VarStmt const& stmt, ResolverContext& context) {
-        declare(stmt.name(), context.scopes);
+        declare(stmt.name(), slotOf(stmt), context);
         if (stmt.initializer()) {
             resolve(*stmt.initializer(), context);
         }
-        define(stmt.name(), context.scopes);
+        define(stmt.name(), context);
     }
     void resolveBlockStmt(BlockStmt const& stmt, ResolverContext& context) {
-        beginScope(context.scopes);
+        beginScope(context);
         for (auto* stmt : stmt.statements()) {
             resolve(*stmt, context);
         }
-        endScope(context.scopes);
+        endScope(context);
     }
     void resolveFunctionStmt(FunctionStmt const& stmt, ResolverContext& context) {
-        declare(stmt.name(), context.scopes);
-        define(stmt.name(), context.scopes);
+        declare(stmt.name(), slotOf(stmt), context);
+        define(stmt.name(), context);
         resolveFunction(stmt, FunctionType::FUNCTION, context);
     }
     void resolveExpressionStmt(ExpressionStmt const& stmt, ResolverContext& context) {
@@ -116,9 +215,9 @@ namespace {
     void resolveClassStmt(ClassStmt const& stmt, ResolverContext& context) {
         auto const enclosingClass = std::exchange(context.currentClass, ClassType::CLASS);
 
-        declare(stmt.name(), context.scopes);
-        define(stmt.name(), context.scopes);
-        
+        declare(stmt.name(), slotOf(stmt), context);
+        define(stmt.name(), context);
+
         if (stmt.superclass()) {
             context.currentClass = ClassType::SUBCLASS;
             if (stmt.name().lexeme() == stmt.superclass()->name().lexeme()) {
@@ -127,15 +226,18 @@ namespace {
             resolveVariableExpr(*stmt.superclass(), context);
         }
 
-        beginScope(context.scopes);
-        context.scopes.back()["this"] = true;
-        if (stmt.superclass()) context.scopes.back()["super"] = true;
+        // 'super' is a local of a scope around the methods, which capture it.
+        if (stmt.superclass()) {
+            beginScope(context);
+            declare("super", context)->references.push_back([&stmt](VariableSlot const& slot) { stmt.resolveSuperSlot(slot); });
+            define("super", context);
+        }
 
         for (auto const* method : stmt.methods()) {
             resolveFunction(*method, method->name().lexeme() == "init" ? FunctionType::INITIALIZER : FunctionType::METHOD, context);
         }
 
-        endScope(context.scopes);
+        if (stmt.superclass()) endScope(context);
 
         context.currentClass = enclosingClass;
     }
@@ -144,11 +246,11 @@ namespace {
     void resolveVariableExpr(VariableExpr const& expr, ResolverContext& context) {
         auto const& key = expr.name().lexeme();
         auto const& scopes = context.scopes;
-        if (!scopes.empty() && scopes.back().contains(key) && !scopes.back().at(key))
+        if (!scopes.empty() && scopes.back().variables.contains(key) && !scopes.back().variables.at(key).defined)
         {
             Lox::error(expr.name(), "Can't read local variable in its own initializer.");
         }
-        resolveLocal(expr, expr.name(), context);
+        resolveLocal(key, slotOf(expr), context);
     }
     void resolveBinaryExpr(BinaryExpr const& expr, ResolverContext& context) {
         resolve(expr.left(), context);
@@ -164,7 +266,7 @@ namespace {
     }
     void resolveAssignExpr(AssignExpr const& expr, ResolverContext& context) {
         resolve(expr.value(), context);
-        resolveLocal(expr, expr.name(), context);
+        resolveLocal(expr.name().lexeme(), slotOf(expr), context);
     }
     void resolveLogicalExpr(LogicalExpr const& expr, ResolverContext& context) {
         resolve(expr.left(), context);
@@ -188,7 +290,7 @@ namespace {
             Lox::error(expr.keyword(), "Can't use 'this' outside of a class.");
         }
         else {
-            resolveLocal(expr, expr.keyword(), context);
+            resolveLocal("this", slotOf(expr), context);
         }
     }
     void resolveSuperExpr(SuperExpr const& expr, ResolverContext& context) {
@@ -198,46 +300,42 @@ namespace {
         else if (context.currentClass == ClassType::CLASS) {
             Lox::error(expr.keyword(), "Can't use 'super' in a class with no superclass.");
         }
-        resolveLocal(expr, expr.keyword(), context);
+        resolveLocal("super", slotOf(expr), context);
+        resolveLocal("this", [&expr](VariableSlot const& slot) { expr.resolveThisSlot(slot); }, context);
     }
 
-    template <typename T>
-    using ResolveStmtFuncT = std::function<void(T const&, ResolverContext&)>;
-
     void resolve(Stmt const& stmt, ResolverContext& context) {
-        static auto const resolveDispatcher = Dispatcher<void, Stmt const&, ResolverContext&>("resolve statement",
-            ResolveStmtFuncT<ExpressionStmt>(resolveExpressionStmt),
-            ResolveStmtFuncT<IfStmt>(resolveIfStmt),
-            ResolveStmtFuncT<PrintStmt>(resolvePrintStmt),
-            ResolveStmtFuncT<WhileStmt>(resolveWhileStmt),
-            ResolveStmtFuncT<VarStmt>(resolveVarStmt),
-            ResolveStmtFuncT<BlockStmt>(resolveBlockStmt),
-            ResolveStmtFuncT<FunctionStmt>(resolveFunctionStmt),
-            ResolveStmtFuncT<ReturnStmt>(resolveReturnStmt),
-            ResolveStmtFuncT<ClassStmt>(resolveClassStmt)
-        );
+        static constexpr auto resolveDispatcher = Dispatcher<void, Stmt const&, ResolverContext&>::create<
+            resolveExpressionStmt,
+            resolveIfStmt,
+            resolvePrintStmt,
+            resolveWhileStmt,
+            resolveVarStmt,
+            resolveBlockStmt,
+            resolveFunctionStmt,
+            resolveReturnStmt,
+            resolveClassStmt
+        >("resolve statement");
 
         resolveDispatcher.dispatch(stmt, context);
     }
     
-    template <typename T>
-    using ResolveExprFuncT = std::function<void(T const&, ResolverContext&)>;
 
     void resolve(Expr const& expr, ResolverContext& context) {
-        static auto const resolveDispatcher = Dispatcher<void, Expr const&, ResolverContext&>("resolve expression",
-            ResolveExprFuncT<BinaryExpr>(resolveBinaryExpr),
-            ResolveExprFuncT<GroupingExpr>(resolveGroupingExpr),
-            ResolveExprFuncT<LiteralExpr>(resolveLiteralExpr),
-            ResolveExprFuncT<UnaryExpr>(resolveUnaryExpr),
-            ResolveExprFuncT<VariableExpr>(resolveVariableExpr),
-            ResolveExprFuncT<AssignExpr>(resolveAssignExpr),
-            ResolveExprFuncT<LogicalExpr>(resolveLogicalExpr),
-            ResolveExprFuncT<CallExpr>(resolveCallExpr),
-            ResolveExprFuncT<GetExpr>(resolveGetExpr),
-            ResolveExprFuncT<SetExpr>(resolveSetExpr),
-            ResolveExprFuncT<ThisExpr>(resolveThisExpr),
-            ResolveExprFuncT<SuperExpr>(resolveSuperExpr)
-        );
+        static constexpr auto resolveDispatcher = Dispatcher<void, Expr const&, ResolverContext&>::create<
+            resolveBinaryExpr,
+            resolveGroupingExpr,
+            resolveLiteralExpr,
+            resolveUnaryExpr,
+            resolveVariableExpr,
+            resolveAssignExpr,
+            resolveLogicalExpr,
+            resolveCallExpr,
+            resolveGetExpr,
+            resolveSetExpr,
+            resolveThisExpr,
+            resolveSuperExpr
+        >("resolve expression");
 
         resolveDispatcher.dispatch(expr, context);
     }
@@ -2,48 +2,107 @@
 #include "Token.h"
 #include "TokenType.h"
 #include "Lox.h"
-#include <unordered_map>
-
-class Scanner {
-public:
-    Scanner(std::string const& source) : mSource(source) {}
-    std::vector<Token> const& scanTokens();
-
-private:
-
-    void scanToken();
-
-    bool isAtEnd() const;
-    char advance();
-
-    void addToken(TokenType type, Object literal = {});
-    bool match(char expected);
-    char peek() const;
-    char peekNext() const;
-    void string();
-    void number();
-    void identifier();
-
-    std::string mSource;
-    std::vector<Token> mTokens;
+#include <algorithm>
+#include <bit>
+#include <string>
+#include <utility>
+
+// SSE2 is part of x86-64, so the scanner can look at 16 characters at a time
+// there without checking what the processor supports. Define LOX_SSE2 as 0 to
+// build the scalar version instead.
+#if !defined(LOX_SSE2)
+#if defined(__SSE2__) || defined(_M_X64)
+#define LOX_SSE2 1
+#else
+#define LOX_SSE2 0
+#endif
+#endif
+
+#if LOX_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+    // The scanner only knows ASCII, so these don't depend on the locale.
+    bool isDigit(char c) { return c >= '0' && c <= '9'; }
+    bool isAlpha(char c) { return (c | 0x20) >= 'a' && (c | 0x20) <= 'z'; }
+
+#if LOX_SSE2
+    constexpr std::size_t blockSize = 16;
+
+    // Every byte of the block from lo to hi. Bytes outside ASCII are negative
+    // and so never in range.
+    __m128i inRange(__m128i block, char lo, char hi) {
+        return _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(static_cast<char>(lo - 1))),
+            _mm_cmplt_epi8(block, _mm_set1_epi8(static_cast<char>(hi + 1))));
+    }
 
-    int mStart = 0;
-    int mCurrent = 0;
-    int mLine = 1;
+    __m128i equal(__m128i block, char c) {
+        return _mm_cmpeq_epi8(block, _mm_set1_epi8(c));
+    }
+#endif
+
+    // The classes of characters that make up runs: each says whether a
+    // character belongs to it and, where vectors are available, which bytes
+    // of a block do.
+    struct Digits {
+        static bool contains(char c) { return isDigit(c); }
+#if LOX_SSE2
+        static __m128i contains(__m128i block) { return inRange(block, '0', '9'); }
+#endif
+    };
+
+    struct AlphaNumerics {
+        static bool contains(char c) { return isAlpha(c) || isDigit(c); }
+#if LOX_SSE2
+        static __m128i contains(__m128i block) {
+            return _mm_or_si128(inRange(block, '0', '9'), inRange(_mm_or_si128(block, _mm_set1_epi8(0x20)), 'a', 'z'));
+        }
+#endif
+    };
+
+    struct Whitespace {
+        static bool contains(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+#if LOX_SSE2
+        static __m128i contains(__m128i block) {
+            return _mm_or_si128(_mm_or_si128(equal(block, ' '), equal(block, '\t')),
+                _mm_or_si128(equal(block, '\r'), equal(block, '\n')));
+        }
+#endif
+    };
+
+    // Where the run of characters of a class that starts at position ends.
+    template <class Class>
+    std::size_t runEnd(std::string_view source, std::size_t position) {
+#if LOX_SSE2
+        while (position + blockSize <= source.size()) {
+            auto const block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source.data() + position));
+            auto const outside = ~static_cast<unsigned>(_mm_movemask_epi8(Class::contains(block))) & 0xFFFFu;
+            if (outside) return position + std::countr_zero(outside);
+            position += blockSize;
+        }
+#endif
+        while (position < source.size() && Class::contains(source[position])) ++position;
+        return position;
+    }
 
-    static std::unordered_map<std::string, TokenType> keywords;
-};
+    // Where the first c from position is, or the end of the source.
+    std::size_t find(std::string_view source, char c, std::size_t position) {
+        return std::min(source.find(c, position), source.size());
+    }
 
+}
 
-std::vector<Token> const& Scanner::scanTokens()
-{
-    while (!isAtEnd()) {
+Token Scanner::next() {
+    while (true) {
+        skipWhitespace();
+        if (isAtEnd()) break;
         mStart = mCurrent;
         scanToken();
+        if (mToken) return *std::exchange(mToken, std::nullopt);
     }
-
-    mTokens.push_back(Token(TokenType::END_OF_FILE, {}, {}, mLine));
-    return mTokens;
+    return Token(TokenType::END_OF_FILE, {}, mLine);
 }
 
 void Scanner::scanToken() {
@@ -73,24 +132,18 @@ void Scanner::scanToken() {
         break;
     case '/':
         if (match('/')) {
-            while (peek() != '\n' && !isAtEnd()) advance();
+            mCurrent = find(mSource, '\n', mCurrent);
         }
         else {
             addToken(TokenType::SLASH);
         }
         break;
-    case ' ': [[fallthrough]];
-    case '\r': [[fallthrough]];
-    case '\t': break;
-    case '\n':
-        mLine++;
-        break;
     case '"': string(); break;
     default:
-        if (isdigit(c)) {
+        if (isDigit(c)) {
             number();
         }
-        else if (isalpha(c)) {
+        else if (isAlpha(c)) {
             identifier();
         }
         else {
@@ -100,6 +153,13 @@ void Scanner::scanToken() {
     }
 }
 
+void Scanner::skipWhitespace() {
+    if (isAtEnd() || !Whitespace::contains(mSource[mCurrent])) return;
+    auto const end = runEnd<Whitespace>(mSource, mCurrent);
+    mLine += static_cast<int>(std::count(mSource.begin() + mCurrent, mSource.begin() + end, '\n'));
+    mCurrent = end;
+}
+
 bool Scanner::isAtEnd() const {
     return mCurrent >= mSource.size();
 }
@@ -108,13 +168,12 @@ char Scanner::advance() {
     return mSource[mCurrent++];
 }
 
-void Scanner::addToken(TokenType type, Object literal) {
+void Scanner::addToken(TokenType type) {
     if (type == TokenType::ENABLE_DEBUG) {
         Lox::debugEnabled = true;
     }
     else {
-        auto const text = mSource.substr(mStart, mCurrent - mStart);
-        mTokens.push_back(Token(type, text, literal, mLine));
+        mToken.emplace(type, mSource.substr(mStart, mCurrent - mStart), mLine);
     }
 }
 
@@ -137,10 +196,9 @@ char Scanner::peekNext() const {
 }
 
 void Scanner::string() {
-    while (peek() != '"' && !isAtEnd()) {
-        if (peek() == '\n') mLine++;
-        advance();
-    }
+    auto const end = find(mSource, '"', mCurrent);
+    mLine += static_cast<int>(std::count(mSource.begin() + mCurrent, mSource.begin() + end, '\n'));
+    mCurrent = end;
 
     if (isAtEnd()) {
         Lox::error(mLine, "Unterminated string.");
@@ -149,54 +207,32 @@ void Scanner::string() {
 
     advance(); // the closing "
 
-    auto const value = mSource.substr(mStart + 1, mCurrent - mStart - 2);
-    addToken(TokenType::STRING, value);
+    addToken(TokenType::STRING);
 }
 
 void Scanner::number() {
-    while (isdigit(peek())) advance();
-    if (peek() == '.' && isdigit(peekNext())) {
-        advance();
-        while (isdigit(peek())) advance();
+    mCurrent = runEnd<Digits>(mSource, mCurrent);
+    if (peek() == '.' && isDigit(peekNext())) {
+        mCurrent = runEnd<Digits>(mSource, mCurrent + 1);
     }
 
-    auto const value = std::stod(mSource.substr(mStart, mCurrent - mStart));
-
-    addToken(TokenType::NUMBER, value);
+    addToken(TokenType::NUMBER);
 }
 
 void Scanner::identifier() {
-    while (isalnum(peek())) advance();
+    mCurrent = runEnd<AlphaNumerics>(mSource, mCurrent);
 
-    auto const text = mSource.substr(mStart, mCurrent - mStart);
-    if (auto const it = keywords.find(text); it != keywords.end()) {
-        addToken(it->second);
-    }
-    else {
-        addToken(TokenType::IDENTIFIER);
-    }
+    addToken(keywordType(mSource.substr(mStart, mCurrent - mStart)));
 }
 
-std::unordered_map<std::string, TokenType> Scanner::keywords = { 
-    {"and", TokenType::AND},
-    {"class", TokenType::CLASS},
-    {"else", TokenType::ELSE},
-    {"false", TokenType::FALSE},
-    {"for", TokenType::FOR},
-    {"fun", TokenType::FUN},
-    {"if", TokenType::IF},
-    {"nil", TokenType::NIL},
-    {"or", TokenType::OR},
-    {"print", TokenType::PRINT},
-    {"DEBUG", TokenType::ENABLE_DEBUG},
-    {"return", TokenType::RETURN},
-    {"super", TokenType::SUPER},
-    {"this", TokenType::THIS},
-    {"true", TokenType::TRUE},
-    {"var", TokenType::VAR},
-    {"while", TokenType::WHILE}
-};
-
-std::vector<Token> scanTokens(std::string const& source) {
-    return Scanner(source).scanTokens();
+std::vector<Token> scanTokens(std::string_view source) {
+    auto scanner = Scanner(source);
+    auto tokens = std::vector<Token>();
+    // Roughly one token for every few characters, so that typical input needs
+    // a single allocation.
+    tokens.reserve(source.size() / 4 + 1);
+    do {
+        tokens.push_back(scanner.next());
+    } while (tokens.back().tokenType() != TokenType::END_OF_FILE);
+    return tokens;
 }
@@ -1,8 +1,98 @@
 #pragma once
 
+#include "Token.h"
+#include "TokenType.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string_view>
 #include <vector>
-#include <string>
 
-class Token;
+// Scans source one token at a time, so that the parser can pull tokens as it
+// needs them instead of scanning all of them up front. The tokens are views
+// into source, which must outlive them.
+class Scanner {
+public:
+    explicit Scanner(std::string_view source) : mSource(source) {}
 
-std::vector<Token> scanTokens(std::string const& source);
+    // The next token. Once the source is used up, every call returns an
+    // END_OF_FILE token.
+    Token next();
+
+private:
+
+    void scanToken();
+    void skipWhitespace();
+
+    bool isAtEnd() const;
+    char advance();
+
+    void addToken(TokenType type);
+    bool match(char expected);
+    char peek() const;
+    char peekNext() const;
+    void string();
+    void number();
+    void identifier();
+
+    std::string_view mSource;
+    std::optional<Token> mToken; // the token scanToken found, if any
+
+    std::size_t mStart = 0;
+    std::size_t mCurrent = 0;
+    int mLine = 1;
+};
+
+namespace detail {
+
+    struct Keyword {
+        std::string_view text;
+        TokenType tokenType = TokenType::IDENTIFIER;
+    };
+
+    inline constexpr auto keywords = std::to_array<Keyword>({
+        {"and", TokenType::AND},
+        {"class", TokenType::CLASS},
+        {"else", TokenType::ELSE},
+        {"false", TokenType::FALSE},
+        {"for", TokenType::FOR},
+        {"fun", TokenType::FUN},
+        {"if", TokenType::IF},
+        {"nil", TokenType::NIL},
+        {"or", TokenType::OR},
+        {"print", TokenType::PRINT},
+        {"DEBUG", TokenType::ENABLE_DEBUG},
+        {"return", TokenType::RETURN},
+        {"super", TokenType::SUPER},
+        {"this", TokenType::THIS},
+        {"true", TokenType::TRUE},
+        {"var", TokenType::VAR},
+        {"while", TokenType::WHILE}
+    });
+
+    // No two keywords share a slot. text must not be empty.
+    constexpr std::size_t keywordSlot(std::string_view text) {
+        return (static_cast<unsigned char>(text.front()) + 5u * static_cast<unsigned char>(text.back()) + text.size()) % 32;
+    }
+
+    inline constexpr auto keywordSlots = [] {
+        auto slots = std::array<Keyword, 32>();
+        for (auto const& keyword : keywords) slots[keywordSlot(keyword.text)] = keyword;
+        return slots;
+    }();
+
+    static_assert(std::ranges::all_of(keywords, [](Keyword const& keyword) { return keywordSlots[keywordSlot(keyword.text)].text == keyword.text; }),
+        "two keywords hash to the same slot");
+}
+
+// The keyword that text spells, or IDENTIFIER. A perfect hash of its first and
+// last characters and its length picks the one keyword it could be, so telling
+// them apart takes a single comparison.
+constexpr TokenType keywordType(std::string_view text) {
+    auto const& slot = detail::keywordSlots[detail::keywordSlot(text)];
+    return slot.text == text ? slot.tokenType : TokenType::IDENTIFIER;
+}
+
+// All the tokens in source, ending with END_OF_FILE.
+std::vector<Token> scanTokens(std::string_view source);
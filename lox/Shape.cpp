@@ -0,0 +1,19 @@
+#include "Shape.h"
+#include <algorithm>
+
+Shape::Shape(Shape const& parent, Symbol name) : mNames(parent.mNames) {
+    mNames.push_back(name);
+}
+
+int Shape::find(Symbol name) const {
+    // Instances rarely have more than a handful of fields, for which a scan
+    // comparing symbol pointers beats hashing.
+    auto const it = std::ranges::find(mNames, name);
+    return it == mNames.end() ? -1 : static_cast<int>(it - mNames.begin());
+}
+
+Shape const* Shape::with(Symbol name) const {
+    auto& child = mTransitions[name];
+    if (!child) child.reset(new Shape(*this, name));
+    return child.get();
+}
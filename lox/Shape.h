@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Symbol.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// The layout of an instance's fields: which field lives in which slot of the
+// instance's value array. Every class owns an empty root shape. Adding a field
+// moves an instance to a child shape that has one more slot, created the first
+// time any instance of the class adds that field in that state. Instances that
+// got the same fields in the same order therefore share one shape, and a shape
+// identifies both the class and the layout of its instances.
+//
+// Child shapes are owned by their parent and live as long as the class.
+class Shape {
+public:
+    Shape() = default;
+    Shape(Shape const&) = delete;
+    Shape& operator=(Shape const&) = delete;
+
+    // The slot holding name, or -1 when instances of this shape lack it.
+    int find(Symbol name) const;
+
+    // The shape of an instance of this shape after adding name.
+    Shape const* with(Symbol name) const;
+
+    int slotCount() const { return static_cast<int>(mNames.size()); }
+
+private:
+    Shape(Shape const& parent, Symbol name);
+
+    std::vector<Symbol> mNames;
+    mutable std::unordered_map<Symbol, std::unique_ptr<Shape>> mTransitions;
+};
@@ -0,0 +1,79 @@
+#include "Source.h"
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+// Files are mapped rather than copied into a string where POSIX mmap exists.
+#if defined(__unix__) || defined(__APPLE__)
+#define LOX_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define LOX_MMAP 0
+#endif
+
+Source::Source(std::string text)
+    : mString(std::make_unique<std::string const>(std::move(text)))
+    , mText(*mString) {
+}
+
+Source::Source(Source&& other) noexcept
+    : mString(std::move(other.mString))
+    , mMapping(std::exchange(other.mMapping, nullptr))
+    , mMappingSize(std::exchange(other.mMappingSize, 0))
+    , mText(std::exchange(other.mText, {})) {
+}
+
+Source& Source::operator=(Source&& other) noexcept {
+    if (this != &other) {
+        release();
+        mString = std::move(other.mString);
+        mMapping = std::exchange(other.mMapping, nullptr);
+        mMappingSize = std::exchange(other.mMappingSize, 0);
+        mText = std::exchange(other.mText, {});
+    }
+    return *this;
+}
+
+Source::~Source() {
+    release();
+}
+
+void Source::release() {
+#if LOX_MMAP
+    if (mMapping) munmap(mMapping, mMappingSize);
+#endif
+    mMapping = nullptr;
+    mMappingSize = 0;
+    mString.reset();
+    mText = {};
+}
+
+std::optional<Source> Source::fromFile(std::string const& path) {
+#if LOX_MMAP
+    if (auto const fd = open(path.c_str(), O_RDONLY); fd >= 0) {
+        struct stat status;
+        auto const isFile = fstat(fd, &status) == 0 && S_ISREG(status.st_mode);
+        auto const size = isFile ? static_cast<std::size_t>(status.st_size) : 0;
+        // An empty file has nothing to map, and other files, such as pipes,
+        // are read below.
+        auto const mapping = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (mapping != MAP_FAILED) {
+            // The scanner reads the text front to back, once.
+            madvise(mapping, size, MADV_SEQUENTIAL);
+            auto source = Source();
+            source.mMapping = mapping;
+            source.mMappingSize = size;
+            source.mText = std::string_view(static_cast<char const*>(mapping), size);
+            return source;
+        }
+        if (isFile && size == 0) return Source(std::string());
+    }
+#endif
+    auto file = std::ifstream(path, std::ios::binary);
+    if (!file) return std::nullopt;
+    return Source(std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+}
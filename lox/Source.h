@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// The text of a script. Tokens are views into it, so the characters stay put
+// for as long as the source lives, even when the source itself is moved. A
+// file is mapped into memory where the platform allows it rather than read;
+// any other text is kept in a string on the heap.
+class Source {
+public:
+    Source() = default;
+    explicit Source(std::string text);
+    Source(Source&& other) noexcept;
+    Source& operator=(Source&& other) noexcept;
+    Source(Source const&) = delete;
+    Source& operator=(Source const&) = delete;
+    ~Source();
+
+    // The contents of a file, or nullopt if it cannot be read.
+    static std::optional<Source> fromFile(std::string const& path);
+
+    std::string_view text() const { return mText; }
+    bool isMapped() const { return mMapping != nullptr; }
+
+private:
+    void release();
+
+    std::unique_ptr<std::string const> mString;
+    void* mMapping = nullptr;
+    std::size_t mMappingSize = 0;
+    std::string_view mText;
+};
@@ -2,41 +2,59 @@
 #include "Expr.h"
 #include <cassert>
 
-ExpressionStmt::ExpressionStmt(Expr const* expression) : mExpression(expression) {
+ExpressionStmt::ExpressionStmt(Expr const* expression) : Stmt(nodeKind), mExpression(expression) {
     assert(expression && "ExpressionStmt ctor: expression cannot be nullptr");
 }
 
-PrintStmt::PrintStmt(Expr const* expression) : mExpression(expression) {
+PrintStmt::PrintStmt(Expr const* expression) : Stmt(nodeKind), mExpression(expression) {
     assert(expression && "PrintStmt ctor: expression cannot be nullptr");
 }
 
-VarStmt::VarStmt(Token const& name, Expr const* initializer) : mName(name), mInitializer(initializer) {
+VarStmt::VarStmt(Token const& name, Expr const* initializer) : Stmt(nodeKind), mName(name), mInitializer(initializer) {
 }
 
-BlockStmt::BlockStmt(std::vector<Stmt const*> const& statements) : mStatements(statements) {
+BlockStmt::BlockStmt(std::vector<Stmt const*> const& statements) : Stmt(nodeKind), mStatements(statements) {
     for (auto const* stmt : statements) { 
         assert(stmt); 
     }
 }
 
-IfStmt::IfStmt(Expr const* condition, Stmt const* thenBranch, Stmt const* elseBranch) : mCondition(condition), mThenBranch(thenBranch), mElseBranch(elseBranch) {
+IfStmt::IfStmt(Expr const* condition, Stmt const* thenBranch, Stmt const* elseBranch) : Stmt(nodeKind), mCondition(condition), mThenBranch(thenBranch), mElseBranch(elseBranch) {
     assert(condition && "IfStmt ctor: condition cannot be null");
     assert(condition && "IfStmt ctor: then branch cannot be null");
 }
 
-WhileStmt::WhileStmt(Expr const* condition, Stmt const* const& body) : mCondition(condition), mBody(body) {
+WhileStmt::WhileStmt(Expr const* condition, Stmt const* const& body) : Stmt(nodeKind), mCondition(condition), mBody(body) {
     assert(condition && "WhileStmt ctor: condition cannot be null");
     assert(condition && "WhileStmt ctor: body cannot be null");
 }
 
-FunctionStmt::FunctionStmt(Token const& name, std::vector<Token> const& parameters, BlockStmt const& body) : mName(name), mParameters(parameters), mBody(body) {
+bool WhileStmt::isEndless() const {
+    return mCondition->kind() == ExprKind::LITERAL && static_cast<LiteralExpr const*>(mCondition)->value() == Object(true);
 }
 
-ReturnStmt::ReturnStmt(Token const& keyword, Expr const* value) : mKeyword(keyword), mValue(value) {
+FunctionStmt::FunctionStmt(Token const& name, std::vector<Token> const& parameters, BlockStmt const& body) : Stmt(nodeKind), mName(name), mParameters(parameters), mBody(body) {
 }
 
-ClassStmt::ClassStmt(Token const& name, VariableExpr const* superclass, std::vector<FunctionStmt const*> const& methods) : mName(name), mSuperclass(superclass), mMethods(methods) {
+ReturnStmt::ReturnStmt(Token const& keyword, Expr const* value) : Stmt(nodeKind), mKeyword(keyword), mValue(value) {
+}
+
+ClassStmt::ClassStmt(Token const& name, VariableExpr const* superclass, std::vector<FunctionStmt const*> const& methods) : Stmt(nodeKind), mName(name), mSuperclass(superclass), mMethods(methods) {
     for (auto const* method : methods) {
         assert(method && "ClassStmt ctor: Method cannot be nullptr.");
     }
 }
+
+CountedLoopStmt::CountedLoopStmt(BinaryExpr const* condition, Stmt const* body, CompoundAssignExpr const* increment) : Stmt(nodeKind), mCondition(condition), mBody(body), mIncrement(increment) {
+    assert(condition && condition->left().kind() == ExprKind::VARIABLE && "CountedLoopStmt ctor: condition must compare a variable");
+    assert(body && "CountedLoopStmt ctor: body cannot be null");
+    assert(increment && "CountedLoopStmt ctor: increment cannot be null");
+}
+
+VariableExpr const& CountedLoopStmt::counter() const {
+    return static_cast<VariableExpr const&>(mCondition->left());
+}
+
+Expr const& CountedLoopStmt::limit() const {
+    return mCondition->right();
+}
@@ -1,17 +1,37 @@
 #pragma once
 #include "Token.h"
+#include "VariableSlot.h"
+#include <cstddef>
 #include <vector>
 
 class Expr;
 class VariableExpr;
+class BinaryExpr;
+class CompoundAssignExpr;
+
+enum class StmtKind {
+    EXPRESSION, PRINT, VAR, BLOCK, IF, WHILE, FUNCTION, RETURN, CLASS,
+    // Fused kinds, which the optimizer replaces common patterns with.
+    COUNTED_LOOP
+};
 
 class Stmt {
 public:
+    static constexpr auto kindCount = static_cast<std::size_t>(StmtKind::COUNTED_LOOP) + 1;
+
+    explicit Stmt(StmtKind kind) : mKind(kind) {}
     virtual ~Stmt() = default;
+
+    StmtKind kind() const { return mKind; }
+
+private:
+    StmtKind mKind;
 };
 
 class ExpressionStmt : public Stmt {
 public:
+    static constexpr auto nodeKind = StmtKind::EXPRESSION;
+
     ExpressionStmt(Expr const* expression);
     Expr const& expression() const { return *mExpression; }
 
@@ -21,6 +41,8 @@ private:
 
 class PrintStmt : public Stmt {
 public:
+    static constexpr auto nodeKind = StmtKind::PRINT;
+
     PrintStmt(Expr const* expression);
     Expr const& expression() const { return *mExpression; }
 
@@ -28,19 +50,28 @@ private:
     Expr const* mExpression;
 };
 
+// Declarations get a slot in their function's frame from the resolver, or are
+// global when declared outside any block or function.
 class VarStmt : public Stmt {
 public:
+    static constexpr auto nodeKind = StmtKind::VAR;
+
     VarStmt(Token const& name, Expr const* initializer);
     Token const& name() const { return mName; }
     Expr const* initializer() const { return mInitializer; }
+    VariableSlot const& slot() const { return mSlot; }
+    void resolveSlot(VariableSlot const& slot) const { mSlot = slot; }
 
 private:
     Token mName;
     Expr const* mInitializer;
+    mutable VariableSlot mSlot;
 };
 
 class BlockStmt : public Stmt {
 public:
+    static constexpr auto nodeKind = StmtKind::BLOCK;
+
     BlockStmt(std::vector<Stmt const*> const& statements);
     std::vector<Stmt const*> const& statements() const { return mStatements; }
 
@@ -50,6 +81,8 @@ private:
 
 class IfStmt : public Stmt {
 public:
+    static constexpr auto nodeKind = StmtKind::IF;
+
     IfStmt(Expr const* condition, Stmt const* thenBranch, Stmt const* elseBranch);
     Expr const& condition() const { return *mCondition; }
     Stmt const& thenBranch() const { return *mThenBranch; }
@@ -64,8 +97,13 @@ private:
 
 class WhileStmt : public Stmt {
 public:
+    static constexpr auto nodeKind = StmtKind::WHILE;
+
     WhileStmt(Expr const* condition, Stmt const* const& body);
     Expr const& condition() const { return *mCondition; }
+    // Whether the condition is a literal true, as for a for loop without one,
+    // so that it need not be tested.
+    bool isEndless() const;
     Stmt const& body() const { return *mBody; }
 
 private:
@@ -76,21 +114,31 @@ private:
 
 class FunctionStmt : public Stmt {
 public:
+    static constexpr auto nodeKind = StmtKind::FUNCTION;
+
     FunctionStmt(Token const& name, std::vector<Token> const& parameters, BlockStmt const& body);
     
     Token name() const { return mName; }
     std::vector<Token> const& parameters() const { return mParameters; }
     BlockStmt const& body() const { return mBody; }
+    VariableSlot const& slot() const { return mSlot; }
+    void resolveSlot(VariableSlot const& slot) const { mSlot = slot; }
+    FrameLayout const& layout() const { return mLayout; }
+    void resolveLayout(FrameLayout const& layout) const { mLayout = layout; }
     
 private:
     Token mName;
     std::vector<Token> mParameters;
     BlockStmt mBody;
+    mutable VariableSlot mSlot;
+    mutable FrameLayout mLayout;
 
 };
 
 class ReturnStmt : public Stmt {
 public:
+    static constexpr auto nodeKind = StmtKind::RETURN;
+
     ReturnStmt(Token const& keyword, Expr const* value);
     Token const& keyword() const { return mKeyword; }
     Expr const* value() const { return mValue; }
@@ -102,13 +150,42 @@ private:
 
 class ClassStmt : public Stmt {
 public:
+    static constexpr auto nodeKind = StmtKind::CLASS;
+
     ClassStmt(Token const& name, VariableExpr const* superclass, std::vector<FunctionStmt const*> const& methods);
     Token const& name() const { return mName; }
     VariableExpr const* superclass() const { return mSuperclass; }
     std::vector<FunctionStmt const*> const& methods() const { return mMethods; }
+    VariableSlot const& slot() const { return mSlot; }
+    void resolveSlot(VariableSlot const& slot) const { mSlot = slot; }
+    // Where 'super' lives for the methods of a subclass.
+    VariableSlot const& superSlot() const { return mSuperSlot; }
+    void resolveSuperSlot(VariableSlot const& slot) const { mSuperSlot = slot; }
 
 private:
     Token mName;
     VariableExpr const* mSuperclass;
     std::vector<FunctionStmt const*> mMethods;
+    mutable VariableSlot mSlot;
+    mutable VariableSlot mSuperSlot;
+};
+
+// The loop a for statement like for (...; i < n; i = i + 1) becomes, fused by
+// the optimizer: the condition compares the counter, a variable, and the
+// counter is stepped by a compound assignment after the body.
+class CountedLoopStmt : public Stmt {
+public:
+    static constexpr auto nodeKind = StmtKind::COUNTED_LOOP;
+
+    CountedLoopStmt(BinaryExpr const* condition, Stmt const* body, CompoundAssignExpr const* increment);
+    BinaryExpr const& condition() const { return *mCondition; }
+    VariableExpr const& counter() const;
+    Expr const& limit() const;
+    Stmt const& body() const { return *mBody; }
+    CompoundAssignExpr const& increment() const { return *mIncrement; }
+
+private:
+    BinaryExpr const* mCondition;
+    Stmt const* mBody;
+    CompoundAssignExpr const* mIncrement;
 };
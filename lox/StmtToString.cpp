@@ -0,0 +1,89 @@
+#include <string>
+#include <vector>
+#include "StmtToString.h"
+#include "ExprToString.h"
+#include "Stmt.h"
+#include "Expr.h"
+#include "Dispatcher.h"
+
+namespace {
+
+    std::string statementsToString(std::vector<Stmt const*> const& statements) {
+        auto result = std::string();
+        for (auto const* statement : statements) {
+            result += " " + toString(*statement);
+        }
+        return result;
+    }
+
+    std::string expressionStmtToString(ExpressionStmt const& stmt) {
+        return "(; " + toString(stmt.expression()) + ")";
+    }
+
+    std::string printStmtToString(PrintStmt const& stmt) {
+        return "(print " + toString(stmt.expression()) + ")";
+    }
+
+    std::string varStmtToString(VarStmt const& stmt) {
+        if (!stmt.initializer()) return "(var " + std::string(stmt.name().lexeme()) + ")";
+        return "(var " + std::string(stmt.name().lexeme()) + " " + toString(*stmt.initializer()) + ")";
+    }
+
+    std::string blockStmtToString(BlockStmt const& stmt) {
+        return "(block" + statementsToString(stmt.statements()) + ")";
+    }
+
+    std::string ifStmtToString(IfStmt const& stmt) {
+        auto const elseBranch = stmt.elseBranch() ? " " + toString(*stmt.elseBranch()) : "";
+        return "(if " + toString(stmt.condition()) + " " + toString(stmt.thenBranch()) + elseBranch + ")";
+    }
+
+    std::string whileStmtToString(WhileStmt const& stmt) {
+        return "(while " + toString(stmt.condition()) + " " + toString(stmt.body()) + ")";
+    }
+
+    std::string functionStmtToString(FunctionStmt const& stmt) {
+        auto parameters = std::string();
+        for (auto const& parameter : stmt.parameters()) {
+            parameters += (parameters.empty() ? "" : " ") + std::string(parameter.lexeme());
+        }
+        return "(fun " + std::string(stmt.name().lexeme()) + " (" + parameters + ")" + statementsToString(stmt.body().statements()) + ")";
+    }
+
+    std::string returnStmtToString(ReturnStmt const& stmt) {
+        if (!stmt.value()) return "(return)";
+        return "(return " + toString(*stmt.value()) + ")";
+    }
+
+    std::string classStmtToString(ClassStmt const& stmt) {
+        auto result = "(class " + std::string(stmt.name().lexeme());
+        if (stmt.superclass()) result += " < " + toString(*stmt.superclass());
+        for (auto const* method : stmt.methods()) {
+            result += " " + toString(*method);
+        }
+        return result + ")";
+    }
+
+    std::string countedLoopStmtToString(CountedLoopStmt const& stmt) {
+        return "(for " + toString(stmt.condition()) + " " + toString(stmt.increment()) + " " + toString(stmt.body()) + ")";
+    }
+
+}
+
+std::string toString(Stmt const& stmt) {
+
+    static constexpr auto dispatcher = Dispatcher<std::string, Stmt const&>::create<
+        expressionStmtToString,
+        printStmtToString,
+        varStmtToString,
+        blockStmtToString,
+        ifStmtToString,
+        whileStmtToString,
+        functionStmtToString,
+        returnStmtToString,
+        classStmtToString,
+        countedLoopStmtToString
+    >("statement to string");
+
+    return dispatcher.dispatch(stmt);
+}
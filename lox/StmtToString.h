@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+
+class Stmt;
+
+std::string toString(Stmt const& stmt);
@@ -0,0 +1,38 @@
+#include "Symbol.h"
+#include <unordered_map>
+
+namespace {
+
+    // Keys view the entry's own value. The table is never destroyed so that
+    // Objects with static storage duration can still release their strings.
+    using Table = std::unordered_map<std::string_view, Symbol::Entry*>;
+
+    Table& table() {
+        static auto* const table = new Table();
+        return *table;
+    }
+
+}
+
+Symbol::Entry* Symbol::intern(std::string_view value) {
+    auto& entries = table();
+    if (auto const it = entries.find(value); it != entries.end()) {
+        return it->second;
+    }
+    auto const entry = new Entry(value, std::hash<std::string_view>()(value));
+    entries.emplace(entry->value(), entry);
+    return entry;
+}
+
+std::size_t Symbol::internedCount() {
+    return table().size();
+}
+
+void Symbol::Entry::destroy() {
+    table().erase(mValue);
+    delete this;
+}
+
+Symbol::Symbol(std::string_view value) : mEntry(intern(value)) {
+    mEntry->retain();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// An interned, immutable string. Each distinct value is stored once, so
+// comparing symbols compares pointers and the hash is computed only when a
+// value is first interned.
+//
+// Symbols hold on to their entry for the lifetime of the process. String
+// Objects share the same entries through a reference count and release them
+// once the last Object referring to a value is gone.
+class Symbol {
+public:
+    class Entry {
+    public:
+        Entry(Entry const&) = delete;
+        Entry& operator=(Entry const&) = delete;
+
+        std::string const& value() const { return mValue; }
+        std::size_t hash() const { return mHash; }
+
+        void retain() { ++mReferences; }
+        void release() {
+            if (--mReferences == 0) destroy();
+        }
+
+    private:
+        friend class Symbol;
+        Entry(std::string_view value, std::size_t hash) : mValue(value), mHash(hash) {}
+        void destroy();
+
+        std::string const mValue;
+        std::size_t const mHash;
+        std::size_t mReferences = 0;
+    };
+
+    // Returns the entry for value without taking a reference to it.
+    static Entry* intern(std::string_view value);
+    // How many distinct values are interned at the moment.
+    static std::size_t internedCount();
+
+    explicit Symbol(std::string_view value);
+    // For an entry that a symbol already holds on to.
+    explicit Symbol(Entry* entry) : mEntry(entry) {}
+
+    std::string const& str() const { return mEntry->value(); }
+    std::size_t hash() const { return mEntry->hash(); }
+    Entry* entry() const { return mEntry; }
+
+    friend bool operator == (Symbol lhs, Symbol rhs) { return lhs.mEntry == rhs.mEntry; }
+
+private:
+    Entry* mEntry;
+};
+
+template <>
+struct std::hash<Symbol> {
+    std::size_t operator()(Symbol symbol) const noexcept { return symbol.hash(); }
+};
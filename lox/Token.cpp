@@ -1,8 +1,33 @@
 #include "Token.h"
 
 #include "TokenType.h"
+#include <charconv>
+#include <limits>
+#include <system_error>
 
 std::string Token::toString() const {
 
-    return ::toString(mTokenType) + " " + mLexeme;
+    return ::toString(mTokenType) + " " + std::string(mLexeme);
+}
+
+Object Token::literal() const {
+    switch (mTokenType) {
+    case TokenType::NUMBER: {
+        // The scanner only accepts digits with an optional fraction, which
+        // from_chars reads without copying and without looking at the locale.
+        // Out of range, they are too large if their whole part isn't zero
+        // and too small otherwise.
+        auto value = 0.0;
+        auto const [end, error] = std::from_chars(mLexeme.data(), mLexeme.data() + mLexeme.size(), value);
+        if (error == std::errc::result_out_of_range) {
+            auto const whole = mLexeme.substr(0, mLexeme.find('.'));
+            value = whole.find_first_not_of('0') != std::string_view::npos ? std::numeric_limits<double>::infinity() : 0.0;
+        }
+        return value;
+    }
+    case TokenType::STRING:
+        return Object(mLexeme.substr(1, mLexeme.size() - 2)); // without the quotes
+    default:
+        return {};
+    }
 }
@@ -1,28 +1,37 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include "Object.h"
+#include "Symbol.h"
 
 enum class TokenType;
 
 
+// A token is a view into the source it was scanned from, so the source must
+// outlive it; a Program keeps the source its tree was parsed from. Nothing is
+// copied while scanning: the symbol is interned the first time it is asked
+// for and literal values are decoded from the lexeme when the parser needs them.
 class Token {
 public:
     Token(TokenType tokenType,
-        std::string lexeme,
-        Object literal,
-        int line) : mTokenType(tokenType), mLexeme(lexeme), mLiteral(literal), mLine(line) {}
-    
+        std::string_view lexeme,
+        int line) : mTokenType(tokenType), mLine(line), mLexeme(lexeme) {}
+
     std::string toString() const;
     TokenType tokenType() const { return mTokenType; }
-    std::string const& lexeme() const { return mLexeme; }
-    Object const& literal() const { return mLiteral; }
+    std::string_view lexeme() const { return mLexeme; }
+    Symbol symbol() const {
+        if (!mSymbol) mSymbol = Symbol(mLexeme).entry();
+        return Symbol(mSymbol);
+    }
+    Object literal() const;
     int line() const { return mLine; }
 
 private:
 
     TokenType mTokenType;
-    std::string mLexeme;
-    Object mLiteral;
     int mLine;
+    std::string_view mLexeme;
+    mutable Symbol::Entry* mSymbol = nullptr; // interned on first use, and kept for the process
 };
@@ -0,0 +1,504 @@
+#include "VM.h"
+#include "Chunk.h"
+#include "Object.h"
+#include "Lox.h"
+#include "Environment.h"
+#include "LoxCallable.h"
+#include "LoxClass.h"
+#include "LoxInstance.h"
+#include "RuntimeError.h"
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// Labels-as-values lets every instruction jump straight to the next handler
+// instead of going back through a single switch.
+#if defined(__GNUC__) || defined(__clang__)
+#define LOX_COMPUTED_GOTO 1
+#else
+#define LOX_COMPUTED_GOTO 0
+#endif
+
+namespace {
+
+    struct Upvalue : GcObject {
+        explicit Upvalue(std::size_t slot) : slot(slot) {}
+
+        // Open upvalues point into the VM stack, which is traced as a root.
+        void trace(Tracer& tracer) const override {
+            if (!isOpen) tracer.mark(closed);
+        }
+
+        std::size_t slot;
+        Object closed;
+        bool isOpen = true;
+    };
+
+    using Upvalues = std::vector<Upvalue*>;
+
+    // Heap state of a compiled closure, kept alive by the LoxCallable wrapping it.
+    struct Closure : GcObject {
+        Closure(std::shared_ptr<CompiledFunction const> const& function, Upvalues const& upvalues) : function(function), upvalues(upvalues) {}
+
+        void trace(Tracer& tracer) const override {
+            for (auto const* upvalue : upvalues) {
+                tracer.mark(upvalue);
+            }
+        }
+
+        std::shared_ptr<CompiledFunction const> function;
+        Upvalues upvalues;
+    };
+
+    bool isTruthy(Object const& object) {
+        if (object.isNil()) return false;
+        if (object.isBoolean()) return static_cast<bool>(object);
+        return true;
+    }
+
+    void checkNumberOperand(Token const& token, Object const& object) {
+        if (!object.isDouble()) throw RuntimeError{ token, "Operand must be a number." };
+    }
+
+    void checkNumberOperands(Token const& token, Object const& left, Object const& right) {
+        if (!left.isDouble() || !right.isDouble()) throw RuntimeError{ token, "Operands must be numbers." };
+    }
+
+    template <class T>
+    Object loxCall(Object const& callee, LoxCallable::ArgsType arguments, Token const& paren) {
+        auto const& function = static_cast<T>(callee);
+
+        if (static_cast<std::size_t>(function.arity()) != arguments.size()) {
+            throw RuntimeError{ paren, "Expected " + std::to_string(function.arity()) + " arguments but got " + std::to_string(arguments.size()) + "." };
+        }
+
+        return function(arguments);
+    }
+
+    // Not owned by the heap; interpret() registers it as a root so that the
+    // stack and the open upvalues are traced.
+    class VM : public GcObject {
+    public:
+        VM() {
+            mStack.reserve(1024);
+        }
+
+        Object call(CompiledFunction const& function, Upvalues const& upvalues, Object const& receiver, LoxCallable::ArgsType arguments) {
+            auto const base = mStack.size();
+            mStack.push_back(receiver);
+            // The arguments may be viewing the top of mStack itself, which
+            // OP_CALL has made room above so that these pushes don't move it.
+            for (auto const& argument : arguments) {
+                mStack.push_back(argument);
+            }
+            ++mDepth;
+            auto result = run(function, upvalues, base);
+            --mDepth;
+            return result;
+        }
+
+        void reset() {
+            mStack.clear();
+            mOpenUpvalues.clear();
+            mDepth = 0;
+        }
+
+        void trace(Tracer& tracer) const override {
+            tracer.mark(mStack);
+            for (auto const* upvalue : mOpenUpvalues) {
+                tracer.mark(upvalue);
+            }
+        }
+
+    private:
+        Object run(CompiledFunction const& function, Upvalues const& upvalues, std::size_t base);
+        LoxCallable closure(std::shared_ptr<CompiledFunction const> const& function, Upvalues const& upvalues) const;
+        Upvalue* captureUpvalue(std::size_t slot);
+        void closeUpvalues(std::size_t fromSlot);
+
+        Object pop() {
+            auto value = std::move(mStack.back());
+            mStack.pop_back();
+            return value;
+        }
+
+        std::vector<Object> mStack;
+        Upvalues mOpenUpvalues; // sorted by slot
+        int mDepth = 0;         // nested calls of run(), the script's included
+    };
+
+    VM vm;
+
+    LoxCallable VM::closure(std::shared_ptr<CompiledFunction const> const& function, Upvalues const& upvalues) const {
+        auto const state = Lox::heap.allocate<Closure>(function, upvalues);
+        auto const call = [state](Object const& receiver, LoxCallable::ArgsType arguments) {
+            return vm.call(*state->function, state->upvalues, receiver, arguments);
+        };
+        return LoxCallable(call, function->arity, function->name, state);
+    }
+
+    Upvalue* VM::captureUpvalue(std::size_t slot) {
+        auto it = mOpenUpvalues.end();
+        while (it != mOpenUpvalues.begin() && (*std::prev(it))->slot >= slot) {
+            --it;
+            if ((*it)->slot == slot) return *it;
+        }
+        return *mOpenUpvalues.insert(it, Lox::heap.allocate<Upvalue>(slot));
+    }
+
+    void VM::closeUpvalues(std::size_t fromSlot) {
+        while (!mOpenUpvalues.empty() && mOpenUpvalues.back()->slot >= fromSlot) {
+            auto& upvalue = *mOpenUpvalues.back();
+            upvalue.closed = mStack[upvalue.slot];
+            upvalue.isOpen = false;
+            mOpenUpvalues.pop_back();
+        }
+    }
+
+    Object VM::run(CompiledFunction const& function, Upvalues const& upvalues, std::size_t base) {
+        auto const& chunk = function.chunk;
+        auto const& constants = chunk.constants();
+        auto const& tokens = chunk.tokens();
+        auto const& functions = chunk.functions();
+        auto const* ip = chunk.code().data();
+
+        auto const readByte = [&]() -> int {
+            return *ip++;
+        };
+        auto const readShort = [&]() -> int {
+            ip += 2;
+            return (ip[-2] << 8) | ip[-1];
+        };
+        auto const readToken = [&]() -> Token const& {
+            return tokens[readShort()];
+        };
+        auto const numberOperation = [&](auto operation) {
+            auto const& operatr = readToken();
+            auto& left = mStack[mStack.size() - 2];
+            auto const& right = mStack.back();
+            checkNumberOperands(operatr, left, right);
+            left = Object(operation(left.asDouble(), right.asDouble()));
+            mStack.pop_back();
+        };
+        auto const compareAndJump = [&](auto comparison) {
+            auto const& operatr = readToken();
+            auto const offset = readShort();
+            auto const& left = mStack[mStack.size() - 2];
+            auto const& right = mStack.back();
+            checkNumberOperands(operatr, left, right);
+            auto const holds = comparison(left.asDouble(), right.asDouble());
+            mStack.pop_back();
+            mStack.pop_back();
+            if (!holds) ip += offset;
+        };
+
+        // Every handler dispatches after its block has closed: a computed goto
+        // out of a block skips the destructors of the locals declared in it.
+#if LOX_COMPUTED_GOTO
+        static void* const dispatchTable[] = {
+#define LOX_OPCODE_LABEL(name) &&op_##name,
+            LOX_OPCODES(LOX_OPCODE_LABEL)
+#undef LOX_OPCODE_LABEL
+        };
+#define VM_DISPATCH() goto *dispatchTable[*ip++]
+#define VM_CASE(name) op_##name:
+        VM_DISPATCH();
+#else
+#define VM_DISPATCH() continue
+#define VM_CASE(name) case OpCode::name:
+        for (;;) switch (static_cast<OpCode>(*ip++)) {
+#endif
+
+        VM_CASE(CONSTANT) {
+            mStack.push_back(constants[readShort()]);
+        }
+        VM_DISPATCH();
+        VM_CASE(NIL) {
+            mStack.emplace_back();
+        }
+        VM_DISPATCH();
+        VM_CASE(TRUE) {
+            mStack.emplace_back(true);
+        }
+        VM_DISPATCH();
+        VM_CASE(FALSE) {
+            mStack.emplace_back(false);
+        }
+        VM_DISPATCH();
+        VM_CASE(POP) {
+            mStack.pop_back();
+        }
+        VM_DISPATCH();
+        VM_CASE(GET_LOCAL) {
+            mStack.push_back(mStack[base + readByte()]);
+        }
+        VM_DISPATCH();
+        VM_CASE(SET_LOCAL) {
+            mStack[base + readByte()] = mStack.back();
+        }
+        VM_DISPATCH();
+        VM_CASE(GET_GLOBAL) {
+            mStack.push_back(Lox::globals.get(readToken()));
+        }
+        VM_DISPATCH();
+        VM_CASE(DEFINE_GLOBAL) {
+            Lox::globals.define(readToken().symbol(), mStack.back());
+            mStack.pop_back();
+        }
+        VM_DISPATCH();
+        VM_CASE(SET_GLOBAL) {
+            Lox::globals.assign(readToken(), mStack.back());
+        }
+        VM_DISPATCH();
+        VM_CASE(GET_UPVALUE) {
+            auto const& upvalue = *upvalues[readByte()];
+            mStack.push_back(upvalue.isOpen ? mStack[upvalue.slot] : upvalue.closed);
+        }
+        VM_DISPATCH();
+        VM_CASE(SET_UPVALUE) {
+            auto& upvalue = *upvalues[readByte()];
+            (upvalue.isOpen ? mStack[upvalue.slot] : upvalue.closed) = mStack.back();
+        }
+        VM_DISPATCH();
+        VM_CASE(GET_PROPERTY) {
+            auto const& name = readToken();
+            auto& object = mStack.back();
+            if (!object.isLoxInstance()) throw RuntimeError{ name, "Only instances have properties." };
+            object = static_cast<LoxInstance>(object).get(name);
+        }
+        VM_DISPATCH();
+        VM_CASE(SET_PROPERTY) {
+            auto const& name = readToken();
+            auto const value = pop();
+            auto const object = pop();
+            if (!object.isLoxInstance()) throw RuntimeError{ name, "Only instances have properties." };
+            static_cast<LoxInstance>(object).set(name, value);
+            mStack.push_back(value);
+        }
+        VM_DISPATCH();
+        VM_CASE(GET_SUPER) {
+            auto const& method = readToken();
+            auto const superclass = static_cast<LoxClass>(pop());
+            auto const receiver = pop();
+            auto const found = superclass.findMethod(method.symbol());
+            mStack.push_back(found.isLoxCallable() ? Object(static_cast<LoxCallable>(found).bind(static_cast<LoxInstance>(receiver))) : found);
+        }
+        VM_DISPATCH();
+        VM_CASE(EQUAL) {
+            auto const right = pop();
+            mStack.back() = Object(mStack.back() == right);
+        }
+        VM_DISPATCH();
+        VM_CASE(NOT_EQUAL) {
+            auto const right = pop();
+            mStack.back() = Object(mStack.back() != right);
+        }
+        VM_DISPATCH();
+        VM_CASE(GREATER) {
+            numberOperation(std::greater<>());
+        }
+        VM_DISPATCH();
+        VM_CASE(GREATER_EQUAL) {
+            numberOperation(std::greater_equal<>());
+        }
+        VM_DISPATCH();
+        VM_CASE(LESS) {
+            numberOperation(std::less<>());
+        }
+        VM_DISPATCH();
+        VM_CASE(LESS_EQUAL) {
+            numberOperation(std::less_equal<>());
+        }
+        VM_DISPATCH();
+        VM_CASE(ADD) {
+            auto const& operatr = readToken();
+            auto const right = pop();
+            auto& left = mStack.back();
+            if (left.isDouble() && right.isDouble()) {
+                left = Object(left.asDouble() + right.asDouble());
+            }
+            else if (left.isString() || right.isString()) {
+                left = Object(left.toString() + right.toString());
+            }
+            else {
+                throw RuntimeError{ operatr, "Cannot concatenate " + left.toString() + " and " + right.toString() + "." };
+            }
+        }
+        VM_DISPATCH();
+        VM_CASE(SUBTRACT) {
+            numberOperation(std::minus<>());
+        }
+        VM_DISPATCH();
+        VM_CASE(MULTIPLY) {
+            numberOperation(std::multiplies<>());
+        }
+        VM_DISPATCH();
+        VM_CASE(DIVIDE) {
+            numberOperation(std::divides<>());
+        }
+        VM_DISPATCH();
+        VM_CASE(NOT) {
+            mStack.back() = Object(!isTruthy(mStack.back()));
+        }
+        VM_DISPATCH();
+        VM_CASE(NEGATE) {
+            auto const& operatr = readToken();
+            checkNumberOperand(operatr, mStack.back());
+            mStack.back() = Object(-mStack.back().asDouble());
+        }
+        VM_DISPATCH();
+        VM_CASE(PRINT) {
+            std::cout << pop().toString() << std::endl;
+        }
+        VM_DISPATCH();
+        VM_CASE(JUMP) {
+            auto const offset = readShort();
+            ip += offset;
+        }
+        VM_DISPATCH();
+        VM_CASE(JUMP_IF_FALSE) {
+            auto const offset = readShort();
+            if (!isTruthy(mStack.back())) ip += offset;
+        }
+        VM_DISPATCH();
+        VM_CASE(LOOP) {
+            auto const offset = readShort();
+            ip -= offset;
+            Lox::heap.safepoint();
+        }
+        VM_DISPATCH();
+        VM_CASE(CALL) {
+            auto const argumentCount = readByte();
+            auto const& paren = readToken();
+            auto const calleeSlot = mStack.size() - argumentCount - 1;
+            auto const callee = mStack[calleeSlot];
+            Lox::heap.safepoint();
+            if (mDepth > Lox::maxCallDepth || Lox::nativeStackExhausted()) throw RuntimeError{ paren, "Stack overflow." };
+
+            // The callee and its arguments stay on the stack, and so stay rooted, until the call returns.
+            // Calling a compiled function pushes the receiver and arguments again; reserving room for
+            // them first keeps the view of the arguments valid.
+            mStack.reserve(mStack.size() + argumentCount + 1);
+            auto const arguments = LoxCallable::ArgsType(mStack).subspan(calleeSlot + 1);
+            auto result = Object();
+            if (callee.isLoxCallable()) {
+                result = loxCall<LoxCallable>(callee, arguments, paren);
+            }
+            else if (callee.isLoxClass()) {
+                result = loxCall<LoxClass>(callee, arguments, paren);
+            }
+            else {
+                throw RuntimeError{ paren, "Can only call functions and classes." };
+            }
+            mStack.erase(mStack.begin() + calleeSlot, mStack.end());
+            mStack.push_back(std::move(result));
+        }
+        VM_DISPATCH();
+        VM_CASE(CLOSURE) {
+            auto const& nested = functions[readShort()];
+            auto captured = Upvalues();
+            captured.reserve(nested->upvalueCount);
+            for (int i = 0; i != nested->upvalueCount; ++i) {
+                auto const isLocal = readByte();
+                auto const index = readByte();
+                captured.push_back(isLocal ? captureUpvalue(base + index) : upvalues[index]);
+            }
+            mStack.emplace_back(closure(nested, captured));
+        }
+        VM_DISPATCH();
+        VM_CASE(CLOSE_UPVALUE) {
+            closeUpvalues(mStack.size() - 1);
+            mStack.pop_back();
+        }
+        VM_DISPATCH();
+        VM_CASE(RETURN) {
+            auto result = pop();
+            closeUpvalues(base);
+            mStack.erase(mStack.begin() + base, mStack.end());
+            return result;
+        }
+        VM_CASE(INHERIT) {
+            auto const& name = readToken();
+            if (!mStack.back().isLoxClass()) throw RuntimeError{ name, "Superclass must be a class" };
+        }
+        VM_DISPATCH();
+        VM_CASE(CLASS) {
+            auto const& name = readToken();
+            auto const methodCount = readByte();
+            auto const hasSuperclass = readByte();
+            auto const firstMethod = mStack.size() - methodCount;
+            auto methods = std::unordered_map<Symbol, LoxCallable>();
+            for (int i = 0; i != methodCount; ++i) {
+                methods.insert(std::pair(readToken().symbol(), static_cast<LoxCallable>(mStack[firstMethod + i])));
+            }
+            mStack.erase(mStack.begin() + firstMethod, mStack.end());
+            auto const superclass = hasSuperclass ? std::optional(static_cast<LoxClass>(mStack.back())) : std::nullopt;
+            mStack.emplace_back(LoxClass(std::string(name.lexeme()), superclass, methods));
+        }
+        VM_DISPATCH();
+        VM_CASE(ADD_LOCAL) {
+            auto& local = mStack[base + readByte()];
+            auto const& constant = constants[readShort()];
+            auto const& operatr = readToken();
+            if (local.isDouble()) {
+                local = Object(local.asDouble() + constant.asDouble());
+            }
+            else if (local.isString()) {
+                local = Object(local.toString() + constant.toString());
+            }
+            else {
+                throw RuntimeError{ operatr, "Cannot concatenate " + local.toString() + " and " + constant.toString() + "." };
+            }
+            mStack.push_back(local);
+        }
+        VM_DISPATCH();
+        VM_CASE(SUBTRACT_LOCAL) {
+            auto& local = mStack[base + readByte()];
+            auto const& constant = constants[readShort()];
+            auto const& operatr = readToken();
+            checkNumberOperands(operatr, local, constant);
+            local = Object(local.asDouble() - constant.asDouble());
+            mStack.push_back(local);
+        }
+        VM_DISPATCH();
+        VM_CASE(JUMP_IF_NOT_LESS) {
+            compareAndJump(std::less<>());
+        }
+        VM_DISPATCH();
+        VM_CASE(JUMP_IF_NOT_LESS_EQUAL) {
+            compareAndJump(std::less_equal<>());
+        }
+        VM_DISPATCH();
+        VM_CASE(JUMP_IF_NOT_GREATER) {
+            compareAndJump(std::greater<>());
+        }
+        VM_DISPATCH();
+        VM_CASE(JUMP_IF_NOT_GREATER_EQUAL) {
+            compareAndJump(std::greater_equal<>());
+        }
+        VM_DISPATCH();
+
+#if !LOX_COMPUTED_GOTO
+        }
+#endif
+#undef VM_DISPATCH
+#undef VM_CASE
+    }
+}
+
+Object interpret(CompiledFunction const& script) {
+    try {
+        auto const vmRoot = Lox::heap.root(vm);
+        auto const globalsRoot = Lox::heap.root(Lox::globals);
+        return vm.call(script, {}, Object(), {});
+    }
+    catch (RuntimeError const& error) {
+        vm.reset();
+        Lox::error(error.token, error.message);
+        return {};
+    }
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "Object.h"
+
+struct CompiledFunction;
+
+Object interpret(CompiledFunction const& script);
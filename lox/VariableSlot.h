@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+// Where the resolver placed a variable, relative to the function that refers
+// to it. Locals live in a slot of their function's frame, unless a closure
+// captures them: then they are boxed in a cell of that frame, shared with the
+// closures as one of their upvalues. Unresolved variables are globals and are
+// looked up by name.
+struct VariableSlot {
+    enum class Kind { GLOBAL, LOCAL, CELL, UPVALUE };
+
+    Kind kind = Kind::GLOBAL;
+    int index = -1;
+
+    bool isGlobal() const { return kind == Kind::GLOBAL; }
+};
+
+// Where a closure finds one of its upvalues when it is created: a cell of the
+// enclosing function's frame, or an upvalue of the enclosing function.
+struct Capture {
+    bool fromCell;
+    int index;
+};
+
+// A parameter (or 'this') that closures capture, moved from its slot into a
+// cell when the function is called.
+struct CapturedParameter {
+    int slot;
+    int cell;
+};
+
+// What the resolver worked out about a function: the size of its frame, which
+// parameters to box on entry and what its closures capture.
+struct FrameLayout {
+    int slotCount = 0;
+    int cellCount = 0;
+    std::vector<CapturedParameter> capturedParameters;
+    std::vector<Capture> captures;
+};
@@ -0,0 +1,94 @@
+// Measures recursive call throughput: the cost of leaving a function by
+// throwing a Return exception, as the tree-walking interpreter used to,
+// against passing a completion back through the return value, and the
+// resulting throughput of a recursive Lox function.
+
+#include "Scanner.h"
+#include "Parser.h"
+#include "Resolver.h"
+#include "Interpreter.h"
+#include "Token.h"
+#include "Lox.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+
+    struct Return {
+        double value;
+    };
+
+    struct Completion {
+        double value;
+        bool returning = false;
+    };
+
+    // Both versions mirror the shape of the interpreter: the return statement
+    // is a few frames below the call that picks up its value.
+    [[gnu::noinline]] void fibBodyBefore(double n);
+
+    [[gnu::noinline]] double fibBefore(double n) {
+        try {
+            fibBodyBefore(n);
+        }
+        catch (Return const& ret) {
+            return ret.value;
+        }
+        return 0;
+    }
+
+    void fibBodyBefore(double n) {
+        if (n < 2) throw Return{ n };
+        throw Return{ fibBefore(n - 2) + fibBefore(n - 1) };
+    }
+
+    [[gnu::noinline]] Completion fibBodyAfter(double n);
+
+    [[gnu::noinline]] double fibAfter(double n) {
+        auto const completion = fibBodyAfter(n);
+        return completion.returning ? completion.value : 0;
+    }
+
+    Completion fibBodyAfter(double n) {
+        if (n < 2) return { n, true };
+        return { fibAfter(n - 2) + fibAfter(n - 1), true };
+    }
+
+    // fib(n) makes 2 * fib(n + 1) - 1 calls.
+    double callCount(int n) {
+        auto a = 0.0, b = 1.0;
+        for (int i = 0; i <= n; ++i) {
+            auto const next = a + b;
+            a = b;
+            b = next;
+        }
+        return 2 * a - 1;
+    }
+
+    template <class Function>
+    void measure(char const* name, int n, Function function) {
+        auto const start = std::chrono::steady_clock::now();
+        auto const result = function(n);
+        auto const end = std::chrono::steady_clock::now();
+        auto const seconds = std::chrono::duration<double>(end - start).count();
+        std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(2)
+            << callCount(n) / seconds / 1e6 << " Mcalls/s (fib(" << n << ") = " << result << ")" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    auto const n = argc > 1 ? std::stoi(argv[1]) : 25;
+
+    measure("before: return by exception", n, fibBefore);
+    measure("after: return by completion", n, fibAfter);
+    measure("interpreter: Lox fib", n, [](int n) {
+        auto const source = "fun fib(n) { if (n < 2) return n; return fib(n - 2) + fib(n - 1); }\nfib(" + std::to_string(n) + ");";
+        auto const program = parse(scanTokens(source));
+        resolve(program.statements());
+        return static_cast<double>(interpret(program.statements()));
+    });
+
+    return Lox::hadError ? 1 : 0;
+}
@@ -0,0 +1,141 @@
+// Measures the cost of dispatching on an AST node: the original
+// typeid/std::function dispatcher against the kind-indexed Dispatcher
+// and a hand-written switch.
+
+#include "Dispatcher.h"
+#include "Expr.h"
+#include "Token.h"
+#include "TokenType.h"
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+    // The dispatcher as it was before node kinds were introduced.
+    template <class ReturnType, class BaseType, class... Args>
+    class TypeIndexDispatcher {
+    public:
+        template <class... ConcreteTypes>
+        TypeIndexDispatcher(std::function<ReturnType(ConcreteTypes, Args...)>&&... concreteFunctions) {
+            (add<ConcreteTypes>(std::forward<decltype(concreteFunctions)>(concreteFunctions)), ...);
+        }
+
+        template <class ConcreteType>
+        void add(std::function<ReturnType(ConcreteType, Args...)>&& concreteFunction) {
+            mDispatcher.emplace(
+                typeid(ConcreteType),
+                [=](BaseType base, Args&&... args) {
+                    return concreteFunction(dynamic_cast<ConcreteType>(base), std::forward<Args>(args)...);
+                });
+        }
+
+        ReturnType dispatch(BaseType object, Args... args) const {
+            return mDispatcher.find(typeid(object))->second(object, args...);
+        }
+
+    private:
+        std::unordered_map<std::type_index, std::function<ReturnType(BaseType, Args...)>> mDispatcher;
+    };
+
+    long long visitBinary(BinaryExpr const&, long long& counter) { return counter += 1; }
+    long long visitUnary(UnaryExpr const&, long long& counter) { return counter += 2; }
+    long long visitGrouping(GroupingExpr const&, long long& counter) { return counter += 3; }
+    long long visitLiteral(LiteralExpr const&, long long& counter) { return counter += 4; }
+    long long visitVariable(VariableExpr const&, long long& counter) { return counter += 5; }
+    long long visitThis(ThisExpr const&, long long& counter) { return counter += 6; }
+
+    template <class T>
+    using VisitFuncT = std::function<long long(T const&, long long&)>;
+
+    long long dispatchBefore(Expr const& expr, long long& counter) {
+        static auto const dispatcher = TypeIndexDispatcher<long long, Expr const&, long long&>(
+            VisitFuncT<BinaryExpr>(visitBinary),
+            VisitFuncT<UnaryExpr>(visitUnary),
+            VisitFuncT<GroupingExpr>(visitGrouping),
+            VisitFuncT<LiteralExpr>(visitLiteral),
+            VisitFuncT<VariableExpr>(visitVariable),
+            VisitFuncT<ThisExpr>(visitThis)
+        );
+        return dispatcher.dispatch(expr, counter);
+    }
+
+    long long dispatchAfter(Expr const& expr, long long& counter) {
+        static constexpr auto dispatcher = Dispatcher<long long, Expr const&, long long&>::create<
+            visitBinary,
+            visitUnary,
+            visitGrouping,
+            visitLiteral,
+            visitVariable,
+            visitThis
+        >("visit");
+        return dispatcher.dispatch(expr, counter);
+    }
+
+    long long dispatchSwitch(Expr const& expr, long long& counter) {
+        switch (expr.kind()) {
+        case ExprKind::BINARY: return visitBinary(static_cast<BinaryExpr const&>(expr), counter);
+        case ExprKind::UNARY: return visitUnary(static_cast<UnaryExpr const&>(expr), counter);
+        case ExprKind::GROUPING: return visitGrouping(static_cast<GroupingExpr const&>(expr), counter);
+        case ExprKind::LITERAL: return visitLiteral(static_cast<LiteralExpr const&>(expr), counter);
+        case ExprKind::VARIABLE: return visitVariable(static_cast<VariableExpr const&>(expr), counter);
+        case ExprKind::THIS: return visitThis(static_cast<ThisExpr const&>(expr), counter);
+        default: return counter;
+        }
+    }
+
+    template <class Function>
+    void measure(char const* name, std::vector<Expr const*> const& nodes, int iterations, Function function) {
+        long long counter = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (int i = 0; i != iterations; ++i) {
+            for (auto const* node : nodes) {
+                function(*node, counter);
+            }
+        }
+        auto const end = std::chrono::steady_clock::now();
+        auto const dispatches = static_cast<double>(nodes.size()) * iterations;
+        auto const nanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+        std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(2)
+            << nanoseconds / dispatches << " ns/dispatch (checksum " << counter << ")" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    auto const iterations = argc > 1 ? std::stoi(argv[1]) : 10000;
+
+    auto const name = Token(TokenType::IDENTIFIER, "x", 1);
+    auto const minus = Token(TokenType::MINUS, "-", 1);
+    auto const self = Token(TokenType::THIS, "this", 1);
+    auto const literal = LiteralExpr(1.0);
+
+    auto storage = std::vector<std::unique_ptr<Expr>>();
+    auto engine = std::mt19937(42);
+    auto distribution = std::uniform_int_distribution(0, 5);
+    for (int i = 0; i != 1024; ++i) {
+        switch (distribution(engine)) {
+        case 0: storage.push_back(std::make_unique<BinaryExpr>(&literal, minus, &literal)); break;
+        case 1: storage.push_back(std::make_unique<UnaryExpr>(minus, &literal)); break;
+        case 2: storage.push_back(std::make_unique<GroupingExpr>(&literal)); break;
+        case 3: storage.push_back(std::make_unique<LiteralExpr>(2.0)); break;
+        case 4: storage.push_back(std::make_unique<VariableExpr>(name)); break;
+        default: storage.push_back(std::make_unique<ThisExpr>(self)); break;
+        }
+    }
+
+    auto nodes = std::vector<Expr const*>();
+    for (auto const& node : storage) nodes.push_back(node.get());
+
+    std::cout << nodes.size() << " nodes x " << iterations << " iterations" << std::endl;
+    measure("before: typeid + std::function", nodes, iterations, dispatchBefore);
+    measure("after: kind-indexed Dispatcher", nodes, iterations, dispatchAfter);
+    measure("reference: switch on kind()", nodes, iterations, dispatchSwitch);
+
+    return 0;
+}
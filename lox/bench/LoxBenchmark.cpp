@@ -0,0 +1,274 @@
+// Runs a corpus of Lox programs through every phase of the interpreter and
+// reports per-phase timings (mean, median and p99 over the runs) and the
+// number of allocations each phase makes. The results can also be written as
+// JSON to track regressions across builds.
+//
+// Usage: lox_bench [--vm] [--runs N] [--json FILE] [program.lox...]
+// Without programs, every .lox file in the bundled corpus is run.
+
+#include "Scanner.h"
+#include "Parser.h"
+#include "Resolver.h"
+#include "Optimizer.h"
+#include "Interpreter.h"
+#include "Compiler.h"
+#include "Chunk.h"
+#include "VM.h"
+#include "Environment.h"
+#include "Token.h"
+#include "Lox.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    std::size_t allocationCount = 0;
+    std::size_t allocatedBytes = 0;
+}
+
+// GCC inlines the replacements into their callers and then warns that memory
+// from malloc is released with delete. Kept out of line, they pair up as
+// written.
+#if defined(__GNUC__) || defined(__clang__)
+#define LOX_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define LOX_NOINLINE __declspec(noinline)
+#else
+#define LOX_NOINLINE
+#endif
+
+LOX_NOINLINE void* operator new(std::size_t size) {
+    ++allocationCount;
+    allocatedBytes += size;
+    if (auto const memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+LOX_NOINLINE void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+LOX_NOINLINE void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+namespace {
+
+    enum class Phase { SCAN, PARSE, RESOLVE, OPTIMIZE, COMPILE, INTERPRET, COUNT };
+
+    constexpr auto phaseCount = static_cast<std::size_t>(Phase::COUNT);
+    constexpr auto phaseNames = std::array<char const*, phaseCount>{ "scan", "parse", "resolve", "optimize", "compile", "interpret" };
+
+    struct PhaseSamples {
+        std::vector<double> microseconds;
+        std::size_t allocations = 0;
+        std::size_t allocatedBytes = 0;
+        std::size_t gcObjects = 0;
+    };
+
+    struct Summary {
+        double mean;
+        double median;
+        double p99;
+    };
+
+    struct Result {
+        std::string name;
+        std::array<PhaseSamples, phaseCount> phases = {};
+        std::vector<double> totals = {};
+    };
+
+    Summary summarise(std::vector<double> samples) {
+        std::ranges::sort(samples);
+        auto const size = samples.size();
+        auto const mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(size);
+        auto const median = size % 2 ? samples[size / 2] : (samples[size / 2 - 1] + samples[size / 2]) / 2;
+        // Nearest-rank percentile.
+        auto const rank = static_cast<std::size_t>(std::ceil(0.99 * static_cast<double>(size)));
+        return { mean, median, samples[std::max<std::size_t>(rank, 1) - 1] };
+    }
+
+    std::optional<std::string> readFile(std::filesystem::path const& path) {
+        auto file = std::ifstream(path);
+        if (!std::filesystem::is_regular_file(path) || !file) return std::nullopt;
+        auto buffer = std::stringstream();
+        buffer << file.rdbuf();
+        return buffer.str();
+    }
+
+    // Runs one phase, adding its time and allocations to the samples. Returns
+    // false when the phase reported an error.
+    template <class Function>
+    bool measure(PhaseSamples& samples, Function function) {
+        auto const allocationsBefore = allocationCount;
+        auto const bytesBefore = allocatedBytes;
+        auto const gcObjectsBefore = Lox::heap.stats().objectsAllocated;
+        auto const start = std::chrono::steady_clock::now();
+        function();
+        auto const end = std::chrono::steady_clock::now();
+        samples.microseconds.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        samples.allocations += allocationCount - allocationsBefore;
+        samples.allocatedBytes += allocatedBytes - bytesBefore;
+        samples.gcObjects += Lox::heap.stats().objectsAllocated - gcObjectsBefore;
+        return !Lox::hadError;
+    }
+
+    bool runOnce(std::string const& source, bool useBytecode, Result& result) {
+        auto& phases = result.phases;
+        auto tokens = std::vector<Token>();
+        auto program = Program();
+        auto script = std::shared_ptr<CompiledFunction const>();
+
+        auto const ok = measure(phases[static_cast<std::size_t>(Phase::SCAN)], [&] { tokens = scanTokens(source); })
+            && measure(phases[static_cast<std::size_t>(Phase::PARSE)], [&] { program = parse(tokens); })
+            && measure(phases[static_cast<std::size_t>(Phase::RESOLVE)], [&] { resolve(program.statements()); })
+            && measure(phases[static_cast<std::size_t>(Phase::OPTIMIZE)], [&] { optimize(program); })
+            && (!useBytecode || measure(phases[static_cast<std::size_t>(Phase::COMPILE)], [&] { script = compile(program.statements()); }))
+            && measure(phases[static_cast<std::size_t>(Phase::INTERPRET)], [&] {
+                if (script) interpret(*script);
+                else interpret(program.statements());
+            });
+
+        auto total = 0.0;
+        for (auto const& phase : phases) {
+            if (!phase.microseconds.empty()) total += phase.microseconds.back();
+        }
+        result.totals.push_back(total);
+
+        // Start the next run from a clean slate, before the program that the
+        // globals' functions refer to goes away.
+        Lox::globals = Environment();
+        Lox::heap.collect();
+        return ok;
+    }
+
+    std::optional<Result> runBenchmark(std::filesystem::path const& path, int runs, bool useBytecode) {
+        auto const source = readFile(path);
+        if (!source) {
+            std::cerr << "lox_bench: cannot read " << path.string() << "." << std::endl;
+            return std::nullopt;
+        }
+        auto result = Result{ path.stem().string() };
+
+        // Programs print their results; keep that out of the report.
+        auto discarded = std::stringstream();
+        auto const oldCout = std::cout.rdbuf(discarded.rdbuf());
+        auto ok = true;
+        for (int run = 0; ok && run != runs; ++run) {
+            ok = runOnce(*source, useBytecode, result);
+            discarded.str({});
+        }
+        std::cout.rdbuf(oldCout);
+
+        if (!ok) {
+            std::cerr << "lox_bench: " << path.string() << " failed." << std::endl;
+            Lox::hadError = false;
+            return std::nullopt;
+        }
+        return result;
+    }
+
+    void printTable(std::vector<Result> const& results, int runs) {
+        std::cout << std::left << std::setw(12) << "program" << std::setw(11) << "phase" << std::right
+            << std::setw(12) << "mean us" << std::setw(12) << "median us" << std::setw(12) << "p99 us"
+            << std::setw(12) << "allocs/run" << std::setw(12) << "gc objs/run" << std::endl;
+        std::cout << std::fixed << std::setprecision(1);
+        for (auto const& result : results) {
+            for (std::size_t i = 0; i != phaseCount; ++i) {
+                auto const& phase = result.phases[i];
+                if (phase.microseconds.empty()) continue;
+                auto const summary = summarise(phase.microseconds);
+                std::cout << std::left << std::setw(12) << result.name << std::setw(11) << phaseNames[i] << std::right
+                    << std::setw(12) << summary.mean << std::setw(12) << summary.median << std::setw(12) << summary.p99
+                    << std::setw(12) << phase.allocations / runs << std::setw(12) << phase.gcObjects / runs << std::endl;
+            }
+            auto const summary = summarise(result.totals);
+            std::cout << std::left << std::setw(12) << result.name << std::setw(11) << "total" << std::right
+                << std::setw(12) << summary.mean << std::setw(12) << summary.median << std::setw(12) << summary.p99 << std::endl;
+        }
+    }
+
+    void writeSummary(std::ostream& out, Summary const& summary) {
+        out << "\"mean_us\": " << summary.mean << ", \"median_us\": " << summary.median << ", \"p99_us\": " << summary.p99;
+    }
+
+    void writeJson(std::ostream& out, std::vector<Result> const& results, int runs, bool useBytecode) {
+        out << std::fixed << std::setprecision(3);
+        out << "{\n  \"engine\": \"" << (useBytecode ? "vm" : "tree-walker") << "\",\n  \"runs\": " << runs << ",\n  \"benchmarks\": [";
+        for (auto const& result : results) {
+            out << (&result == &results.front() ? "\n" : ",\n");
+            out << "    {\n      \"name\": \"" << result.name << "\",\n      \"total\": { ";
+            writeSummary(out, summarise(result.totals));
+            out << " },\n      \"phases\": {";
+            auto first = true;
+            for (std::size_t i = 0; i != phaseCount; ++i) {
+                auto const& phase = result.phases[i];
+                if (phase.microseconds.empty()) continue;
+                out << (first ? "\n" : ",\n") << "        \"" << phaseNames[i] << "\": { ";
+                writeSummary(out, summarise(phase.microseconds));
+                out << ", \"allocations\": " << phase.allocations / runs
+                    << ", \"allocated_bytes\": " << phase.allocatedBytes / runs
+                    << ", \"gc_objects\": " << phase.gcObjects / runs << " }";
+                first = false;
+            }
+            out << "\n      }\n    }";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    std::vector<std::filesystem::path> corpus() {
+        auto programs = std::vector<std::filesystem::path>();
+        for (auto const& entry : std::filesystem::directory_iterator(LOX_BENCH_PROGRAMS)) {
+            if (entry.path().extension() == ".lox") programs.push_back(entry.path());
+        }
+        std::ranges::sort(programs);
+        return programs;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    auto useBytecode = false;
+    auto runs = 10;
+    auto jsonFile = std::string();
+    auto programs = std::vector<std::filesystem::path>();
+
+    for (int i = 1; i < argc; ++i) {
+        auto const argument = std::string(argv[i]);
+        if (argument == "--vm") useBytecode = true;
+        else if (argument == "--runs" && i + 1 < argc) runs = std::max(1, std::stoi(argv[++i]));
+        else if (argument == "--json" && i + 1 < argc) jsonFile = argv[++i];
+        else if (argument.starts_with("--")) {
+            std::cerr << "Usage: lox_bench [--vm] [--runs N] [--json FILE] [program.lox...]" << std::endl;
+            return EXIT_FAILURE;
+        }
+        else programs.push_back(argument);
+    }
+    if (programs.empty()) programs = corpus();
+
+    auto results = std::vector<Result>();
+    auto failed = false;
+    for (auto const& program : programs) {
+        if (auto result = runBenchmark(program, runs, useBytecode)) results.push_back(std::move(*result));
+        else failed = true;
+    }
+
+    printTable(results, runs);
+    if (!jsonFile.empty()) {
+        auto out = std::ofstream(jsonFile);
+        writeJson(out, results, runs, useBytecode);
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,92 @@
+// Measures how fast the scanner gets through large generated sources, in
+// megabytes per second, for a few shapes of input: ordinary code and sources
+// dominated by comments, long identifiers or numbers.
+
+#include "Scanner.h"
+#include "Token.h"
+#include "TokenType.h"
+#include "Lox.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+
+namespace {
+
+    std::string code(std::mt19937& engine) {
+        auto n = std::uniform_int_distribution(0, 9999)(engine);
+        auto const i = std::to_string(n);
+        return "// Sums the counters of entry " + i + ".\n"
+            "fun total" + i + "(first, second) {\n"
+            "    var sum = 0;\n"
+            "    for (var index = 0; index < first.count; index = index + 1) {\n"
+            "        sum = sum + second * " + i + ".25;\n"
+            "    }\n"
+            "    if (sum >= 100 and first != nil) print \"large \" + first.name;\n"
+            "    return sum;\n"
+            "}\n\n";
+    }
+
+    std::string comments(std::mt19937& engine) {
+        auto const i = std::to_string(std::uniform_int_distribution(0, 9999)(engine));
+        return "    // Entry " + i + " is only described here, at some length, so that the scanner has\n"
+            "    // a good deal of commentary to skip before it reaches the next declaration.\n"
+            "    var entry" + i + " = nil;\n";
+    }
+
+    std::string identifiers(std::mt19937& engine) {
+        auto const i = std::to_string(std::uniform_int_distribution(0, 9999)(engine));
+        return "accumulatedRunningTotalOfEntry" + i + " = previousAccumulatedTotalForEntry" + i
+            + " + currentlyObservedMeasurementValue" + i + ";\n";
+    }
+
+    std::string numbers(std::mt19937& engine) {
+        auto digits = std::uniform_int_distribution<long long>(0, 999999999999);
+        return "print " + std::to_string(digits(engine)) + "." + std::to_string(digits(engine))
+            + " + " + std::to_string(digits(engine)) + " * 3141592653589793;\n";
+    }
+
+    template <class Generator>
+    std::string generate(std::size_t size, Generator generator) {
+        auto engine = std::mt19937(42);
+        auto source = std::string();
+        source.reserve(size + 1024);
+        while (source.size() < size) source += generator(engine);
+        return source;
+    }
+
+    void measure(char const* name, std::string_view source, int rounds) {
+        auto best = std::chrono::duration<double>::max();
+        std::size_t tokens = 0;
+        for (int round = 0; round != rounds; ++round) {
+            auto const start = std::chrono::steady_clock::now();
+            auto scanner = Scanner(source);
+            tokens = 0;
+            while (scanner.next().tokenType() != TokenType::END_OF_FILE) ++tokens;
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start));
+        }
+        auto const megabytes = static_cast<double>(source.size()) / (1024 * 1024);
+        std::cout << std::left << std::setw(14) << name << std::right << std::fixed << std::setprecision(1)
+            << std::setw(8) << megabytes / best.count() << " MB/s, "
+            << std::setw(6) << static_cast<double>(tokens) / best.count() / 1e6 << " M tokens/s ("
+            << tokens << " tokens)" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    auto const megabytes = argc > 1 ? std::stoi(argv[1]) : 16;
+    auto const rounds = argc > 2 ? std::stoi(argv[2]) : 5;
+    auto const size = static_cast<std::size_t>(megabytes) * 1024 * 1024;
+
+    std::cout << megabytes << " MB per input, best of " << rounds << " rounds" << std::endl;
+    measure("code", generate(size, code), rounds);
+    measure("comments", generate(size, comments), rounds);
+    measure("identifiers", generate(size, identifiers), rounds);
+    measure("numbers", generate(size, numbers), rounds);
+
+    return Lox::hadError ? 1 : 0;
+}
@@ -4,7 +4,7 @@
 #include "Environment.h"
 
 LogListener::LogListener() {
-    Lox::globals.define("log", LoxCallable([&](LoxCallable::ArgsType args) -> Object {
+    Lox::globals.define(Symbol("log"), LoxCallable([&](LoxCallable::ArgsType args) -> Object {
         mHistory.emplace_back(args[0]);
         return {};
         }, 1, "log"));
@@ -13,5 +13,5 @@ LogListener::LogListener() {
 std::vector<Object> const& LogListener::history() const { return mHistory; }
 
 LogListener::~LogListener() {
-    Lox::globals.remove("log");
+    Lox::globals.remove(Symbol("log"));
 }
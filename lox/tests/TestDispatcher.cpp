@@ -0,0 +1,50 @@
+#include "Dispatcher.h"
+#include "Expr.h"
+#include "Token.h"
+#include "TokenType.h"
+#include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
+#include <string>
+
+using namespace std::string_literals;
+
+namespace {
+
+    std::string visitLiteral(LiteralExpr const& expr) { return "literal " + expr.value().toString(); }
+    std::string visitVariable(VariableExpr const& expr) { return "variable " + std::string(expr.name().lexeme()); }
+    std::string visitBinary(BinaryExpr const& expr) { return "binary " + std::string(expr.operatr().lexeme()); }
+    std::string visitNumberBinary(BinaryExpr const& expr) { return "number " + visitBinary(expr); }
+
+    constexpr auto dispatcher = Dispatcher<std::string, Expr const&>::create<visitLiteral, visitVariable>("test");
+
+    auto const identifier = Token(TokenType::IDENTIFIER, "test", 0);
+
+    TEST_CASE("Nodes report their kind") {
+        REQUIRE(LiteralExpr(1.0).kind() == ExprKind::LITERAL);
+        REQUIRE(VariableExpr(identifier).kind() == ExprKind::VARIABLE);
+        REQUIRE(ThisExpr(identifier).kind() == ExprKind::THIS);
+    }
+
+    TEST_CASE("Dispatcher calls the handler registered for the node kind") {
+        REQUIRE(dispatcher.dispatch(LiteralExpr(1.0)) == "literal 1.0"s);
+        REQUIRE(dispatcher.dispatch(VariableExpr(identifier)) == "variable test"s);
+    }
+
+    TEST_CASE("Dispatcher throws for node kinds without handler") {
+        REQUIRE_THROWS_AS(dispatcher.dispatch(ThisExpr(identifier)), std::runtime_error);
+    }
+
+    TEST_CASE("Dispatcher calls the handler registered for a quickened kind") {
+        constexpr auto quickening = [] {
+            auto quickening = Dispatcher<std::string, Expr const&>::create<visitBinary>("test");
+            quickening.add<ExprKind::NUMBER_BINARY, visitNumberBinary>();
+            return quickening;
+        }();
+        auto const one = LiteralExpr(1.0);
+        auto const binary = BinaryExpr(&one, Token(TokenType::PLUS, "+", 0), &one);
+        REQUIRE(quickening.dispatch(binary) == "binary +"s);
+        binary.quicken(ExprKind::NUMBER_BINARY);
+        REQUIRE(quickening.dispatch(binary) == "number binary +"s);
+    }
+
+}
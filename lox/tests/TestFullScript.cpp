@@ -1,71 +1,98 @@
 #include "Scanner.h"
 #include "Parser.h"
 #include "Resolver.h"
+#include "Optimizer.h"
 #include "Interpreter.h"
+#include "Compiler.h"
+#include "Chunk.h"
+#include "VM.h"
 #include "Object.h"
+#include "Symbol.h"
+#include "Environment.h"
 #include "Lox.h"
 #include "Token.h"
+#include "Source.h"
 #include "LogListener.h"
 #include "TestGuard.h"
 
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
 #include <string>
+#include <vector>
 
 using namespace std::string_literals;
 
 namespace {
 
-    Object RunWitoutGuard(std::string const& source) {
+    // Every script test runs once in each engine.
+    enum class Engine { TREE_WALKER, VM };
 
-        assert(!Lox::hadError);
+    // Later scripts may call functions declared by earlier ones, as in the
+    // REPL, and compiled functions view the source of the script that
+    // declared them.
+    std::vector<Program> retainedPrograms;
+
+    Object RunWitoutGuard(Engine engine, std::string const& source) {
 
-        auto const tokens = scanTokens(source);
-        if (Lox::hadError) return "Scanner error"s;
+        assert(!Lox::hadError);
 
-        auto const statements = parse(tokens);
-        if (Lox::hadError) return "Parser error"s;
+        auto& program = retainedPrograms.emplace_back(parse(Source(source)));
+        auto const& statements = program.statements();
+        if (Lox::hadError) return "Scanner or parser error"s;
 
         resolve(statements);
         if (Lox::hadError) return "Resolver error"s;
 
-        auto const result = interpret(statements);
+        optimize(program);
+
+        auto const script = engine == Engine::VM ? compile(statements) : nullptr;
+        if (Lox::hadError) return "Compiler error"s;
+
+        auto const result = script ? interpret(*script) : interpret(statements);
         if (Lox::hadError) return "Interpreter error"s;
 
         return result;
     }
 
-    Object RunWithGuard(std::string const& source) {
+    Object RunWithGuard(Engine engine, std::string const& source) {
         TestGuard guard;
-        return RunWitoutGuard(source);
+        return RunWitoutGuard(engine, source);
     }
 
     TEST_CASE("Can run a trivial script") {
-        REQUIRE(RunWithGuard("") == Object());
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        REQUIRE(RunWithGuard(engine, "") == Object());
     }
 
     TEST_CASE("Result of last statement is returned.") {
-        REQUIRE(RunWithGuard("5.0;4.0;3.0;") == 3.0);
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        REQUIRE(RunWithGuard(engine, "5.0;4.0;3.0;") == 3.0);
     }
 
     TEST_CASE("Can have global variables.") {
-        REQUIRE(RunWithGuard("var varTest;\nvarTest;") == Object());
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        REQUIRE(RunWithGuard(engine, "var varTest;\nvarTest;") == Object());
     }
 
     TEST_CASE("Can assign to global variables.") {
-        REQUIRE(RunWithGuard("var varTest;\nvarTest = true;\nvarTest;") == true);
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        REQUIRE(RunWithGuard(engine, "var varTest;\nvarTest = true;\nvarTest;") == true);
     }
 
     TEST_CASE("Can have if statements.") {
-        REQUIRE(RunWithGuard("if (true) {} else {}") == Object());
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        REQUIRE(RunWithGuard(engine, "if (true) {} else {}") == Object());
     }
 
     TEST_CASE("Can have for loops.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         LogListener listener;
-        REQUIRE(RunWithGuard("for (var i=0; i != 10; i=i+1){ log(i); }") == Object());
+        REQUIRE(RunWithGuard(engine, "for (var i=0; i != 10; i=i+1){ log(i); }") == Object());
         REQUIRE(listener.history() == std::vector<Object>{0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0});
     }
 
     TEST_CASE("Fibonacci") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
 
         auto const fib = "\
 fun fib(n) {\
@@ -74,20 +101,50 @@ fun fib(n) {\
     return fib(n - 2) + fib(n - 1);\
 }"s;
 
-        REQUIRE(RunWithGuard(fib + "fib(0);"s) == 0.0);
-        REQUIRE(RunWithGuard(fib + "fib(1);"s) == 1.0);
-        REQUIRE(RunWithGuard(fib + "fib(2);"s) == 1.0);
-        REQUIRE(RunWithGuard(fib + "fib(3);"s) == 2.0);
-        REQUIRE(RunWithGuard(fib + "fib(4);"s) == 3.0);
-        REQUIRE(RunWithGuard(fib + "fib(5);"s) == 5.0);
-        REQUIRE(RunWithGuard(fib + "fib(6);"s) == 8.0);
-        REQUIRE(RunWithGuard(fib + "fib(7);"s) == 13.0);
-        REQUIRE(RunWithGuard(fib + "fib(8);"s) == 21.0);
-        REQUIRE(RunWithGuard(fib + "fib(9);"s) == 34.0);
-        REQUIRE(RunWithGuard(fib + "fib(10);"s) == 55.0);
+        REQUIRE(RunWithGuard(engine, fib + "fib(0);"s) == 0.0);
+        REQUIRE(RunWithGuard(engine, fib + "fib(1);"s) == 1.0);
+        REQUIRE(RunWithGuard(engine, fib + "fib(2);"s) == 1.0);
+        REQUIRE(RunWithGuard(engine, fib + "fib(3);"s) == 2.0);
+        REQUIRE(RunWithGuard(engine, fib + "fib(4);"s) == 3.0);
+        REQUIRE(RunWithGuard(engine, fib + "fib(5);"s) == 5.0);
+        REQUIRE(RunWithGuard(engine, fib + "fib(6);"s) == 8.0);
+        REQUIRE(RunWithGuard(engine, fib + "fib(7);"s) == 13.0);
+        REQUIRE(RunWithGuard(engine, fib + "fib(8);"s) == 21.0);
+        REQUIRE(RunWithGuard(engine, fib + "fib(9);"s) == 34.0);
+        REQUIRE(RunWithGuard(engine, fib + "fib(10);"s) == 55.0);
+    }
+
+    TEST_CASE("Return leaves nested loops and blocks.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        auto const script = "\
+fun find(limit) {\
+    for (var i = 0; i < 10; i = i + 1) {\
+        var j = 0;\
+        while (j <= i) {\
+            if (i * j == limit) { return i + j; }\
+            j = j + 1;\
+        }\
+    }\
+    return -1;\
+}"s;
+        REQUIRE(RunWithGuard(engine, script + "find(12);"s) == 7.0);
+    }
+
+    TEST_CASE("Conditions that aren't booleans are truthy unless nil.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        TestGuard guard;
+        REQUIRE(RunWitoutGuard(engine, "var a = 1; if (a) print \"yes\"; var b; if (b) print \"no\"; else print \"else\";") == Object());
+        REQUIRE(RunWitoutGuard(engine, "var c = \"go\"; var k = 0; while (c) { k = k + 1; if (k == 3) c = nil; } print k;") == Object());
+        REQUIRE(guard.capturedLinesCout() == std::vector{ "yes"s, "else"s, "3.0"s });
+    }
+
+    TEST_CASE("Function without return statement returns nil.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        REQUIRE(RunWithGuard(engine, "fun f() { 1 + 2; } f();") == Object());
     }
 
     TEST_CASE("Can return local function.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         LogListener listener;
         auto const script = "\
 fun makeCounter() {\
@@ -102,11 +159,12 @@ var counter = makeCounter();\
 log(counter());\
 log(counter());\
 log(counter());";
-        REQUIRE(RunWithGuard(script) == Object());
+        REQUIRE(RunWithGuard(engine, script) == Object());
         REQUIRE(listener.history() == std::vector<Object>{1.0, 2.0, 3.0});
     }
 
     TEST_CASE("Closure captures variable from correct scope.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         auto const script = "\
 var a = \"global\";\
 {\
@@ -118,23 +176,26 @@ var a = \"global\";\
     log(getA());\
 }";
         LogListener listener;
-        REQUIRE(RunWithGuard(script) == Object());
+        REQUIRE(RunWithGuard(engine, script) == Object());
         REQUIRE(listener.history() == std::vector<Object>{"global"s, "global"s});
     }
 
     TEST_CASE("Can create class instance.") {
-        REQUIRE(RunWithGuard("class Test{} Test();").isLoxInstance());
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        REQUIRE(RunWithGuard(engine, "class Test{} Test();").isLoxInstance());
     }
 
     TEST_CASE("Can set and get property on class instance.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         auto const script = "class Test{}\
 var test = Test();\
 test.property = 3;\
 test.property;";
-        REQUIRE(RunWithGuard(script) == Object(3.0));
+        REQUIRE(RunWithGuard(engine, script) == Object(3.0));
     }
 
     TEST_CASE("Class can have methods.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         auto const script = "\
 class Test{\
     method() {\
@@ -143,10 +204,11 @@ class Test{\
 }\
 var test = Test();\
 test.method();";
-        REQUIRE(RunWithGuard(script) == Object("Method return value"s));
+        REQUIRE(RunWithGuard(engine, script) == Object("Method return value"s));
     }
 
     TEST_CASE("Method can access this.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         auto const script = "\
 class Test{\
     method() {\
@@ -154,10 +216,11 @@ class Test{\
     }\
 }\
 Test().method();";
-        REQUIRE(RunWithGuard(script).isLoxInstance());
+        REQUIRE(RunWithGuard(engine, script).isLoxInstance());
     }
 
     TEST_CASE("Class can have initializer.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         auto const script = "\
 class Test{\
     init(n) {\
@@ -168,91 +231,115 @@ class Test{\
     }\
 }\
 Test(5).get();";
-        REQUIRE(RunWithGuard(script) == Object(5.0));
+        REQUIRE(RunWithGuard(engine, script) == Object(5.0));
     }
 
     TEST_CASE("Can run line by line (REPL)") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         TestGuard guard;
         LogListener listener;
-        REQUIRE(RunWitoutGuard("var test = 3;") == Object());
-        REQUIRE(RunWitoutGuard("log(test);") == Object());
-        REQUIRE(RunWitoutGuard("{\nvar test = 5; log(test);}") == Object());
-        REQUIRE(RunWitoutGuard("log(test);") == Object());
+        REQUIRE(RunWitoutGuard(engine, "var test = 3;") == Object());
+        REQUIRE(RunWitoutGuard(engine, "log(test);") == Object());
+        REQUIRE(RunWitoutGuard(engine, "{\nvar test = 5; log(test);}") == Object());
+        REQUIRE(RunWitoutGuard(engine, "log(test);") == Object());
         REQUIRE(listener.history() == std::vector<Object>{3.0, 5.0, 3.0});
     }
 
     TEST_CASE("Init implicitly returns this.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         auto const script = "\
 class Test{\
     init() {}\
 }\
 Test().init();";
-        REQUIRE(RunWithGuard(script).isLoxInstance());
+        REQUIRE(RunWithGuard(engine, script).isLoxInstance());
 
     }
 
     TEST_CASE("Cannot return value in intializer.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         auto const script = "\
 class Test{\
     init() {return 3;}\
 }";
         TestGuard guard;
-        REQUIRE(RunWitoutGuard(script) == Object("Resolver error"s));
+        REQUIRE(RunWitoutGuard(engine, script) == Object("Resolver error"s));
         REQUIRE(guard.capturedLinesCerr() == std::vector{"[line 1] Error at 'return': Can't return a value from an initializer."s});
     }
 
     TEST_CASE("Can return with no value in intializer.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         auto const script = "\
 class Test{\
     init() {return;}\
 }";
         TestGuard guard;
-        REQUIRE(RunWitoutGuard(script) == Object());
-        REQUIRE(RunWitoutGuard("Test().init();").isLoxInstance());
+        REQUIRE(RunWitoutGuard(engine, script) == Object());
+        REQUIRE(RunWitoutGuard(engine, "Test().init();").isLoxInstance());
 
     }
 
     TEST_CASE("Class can interherit from superclass.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         auto const script = "\
 class Super{}\
 class Sub < Super{}";
-        REQUIRE(RunWithGuard(script) == Object());
+        REQUIRE(RunWithGuard(engine, script) == Object());
     }
 
     TEST_CASE("Class cannot interherit from itself.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         auto const script = "\
 class Class < Class{}";
         TestGuard guard;
-        REQUIRE(RunWitoutGuard(script) == Object("Resolver error"s));
+        REQUIRE(RunWitoutGuard(engine, script) == Object("Resolver error"s));
         REQUIRE(guard.capturedLinesCerr() == std::vector{ "[line 1] Error at 'Class': A class can't inherit from itself."s });
     }
 
     TEST_CASE("Class cannot interherit from a double.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         auto const script = "\
 var test = 3.0;\
 class Class < test {}";
         TestGuard guard;
-        REQUIRE(RunWitoutGuard(script) == Object("Interpreter error"s));
+        REQUIRE(RunWitoutGuard(engine, script) == Object("Interpreter error"s));
         REQUIRE(guard.capturedLinesCerr() == std::vector{"[line 1] Error at 'test': Superclass must be a class"s});
     }
 
     TEST_CASE("Can call methods from superclass.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         auto const script = "\
 class Super {superfun(){return 1.0;}}\
 class Sub < Super {}\
 Sub().superfun();";
-        REQUIRE(RunWithGuard(script) == Object(1.0));
+        REQUIRE(RunWithGuard(engine, script) == Object(1.0));
+    }
+
+    TEST_CASE("Subclass inherits initializer from superclass.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        auto const script = "\
+class Super {init(x){this.x = x;}}\
+class Middle < Super {}\
+class Sub < Middle {}\
+Sub(3).x;";
+        REQUIRE(RunWithGuard(engine, script) == Object(3.0));
+
+        TestGuard guard;
+        REQUIRE(RunWitoutGuard(engine, script + "Sub();"s) == Object("Interpreter error"s));
+        REQUIRE(guard.capturedLinesCerr() == std::vector{"[line 1] Error at ')': Expected 1 arguments but got 0."s});
     }
 
     TEST_CASE("Can specify super to explicitly call method on superclass.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         auto const script = "\
 class Super {method(){return 10.0;}}\
 class Sub < Super {method(){return super.method() - 10;}}\
 Sub().method();";
-        REQUIRE(RunWithGuard(script) == Object(0.0));
+        REQUIRE(RunWithGuard(engine, script) == Object(0.0));
     }
 
     TEST_CASE("Super messy.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
         auto const script = "\
 class A {method(){print \"A method\";}}\
 class B < A {method(){print \"B method\";} test(){super.method();}}\
@@ -264,8 +351,135 @@ var cmethod = C().method;\
 cmethod();\
 ctest();";
         TestGuard guard;
-        REQUIRE(RunWitoutGuard(script) == Object());
+        REQUIRE(RunWitoutGuard(engine, script) == Object());
         REQUIRE(guard.capturedLinesCout() == std::vector{ "B method"s , "A method"s , "B method"s , "A method"s });
 
     }
+
+    TEST_CASE("Recursing deeper than the maximum call depth is a stack overflow.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        auto const maxCallDepth = std::exchange(Lox::maxCallDepth, 100);
+        TestGuard guard;
+        REQUIRE(RunWitoutGuard(engine, "fun f(n) { if (n == 0) return 0; return f(n - 1) + 1; } f(99);") == Object(99.0));
+        REQUIRE(RunWitoutGuard(engine, "fun f(n) { if (n == 0) return 0; return f(n - 1) + 1; } f(100);") == Object("Interpreter error"s));
+        REQUIRE(guard.capturedLinesCerr() == std::vector{ "[line 1] Error at ')': Stack overflow."s });
+        Lox::hadError = false;
+        REQUIRE(RunWitoutGuard(engine, "fun f(n) { if (n == 0) return 0; return f(n - 1) + 1; } f(10);") == Object(10.0));
+        Lox::maxCallDepth = maxCallDepth;
+    }
+
+    TEST_CASE("Running out of native stack is a stack overflow, however high the maximum call depth.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        auto const maxCallDepth = std::exchange(Lox::maxCallDepth, 10000000);
+        TestGuard guard;
+        REQUIRE(RunWitoutGuard(engine, "fun f(n) { return f(n + 1) + 1; } f(0);") == Object("Interpreter error"s));
+        REQUIRE(guard.capturedLinesCerr() == std::vector{ "[line 1] Error at ')': Stack overflow."s });
+        Lox::maxCallDepth = maxCallDepth;
+    }
+
+    TEST_CASE("Operators that have seen numbers still work on other operands.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        TestGuard guard;
+        REQUIRE(RunWitoutGuard(engine, "fun add(a, b) { return a + b; } add(1, 2);") == Object(3.0));
+        REQUIRE(RunWitoutGuard(engine, "add(\"a\", 2);") == Object("a2.0"s));
+        REQUIRE(RunWitoutGuard(engine, "add(2, 3);") == Object(5.0));
+        REQUIRE(RunWitoutGuard(engine, "add(2, nil);") == Object("Interpreter error"s));
+        REQUIRE(guard.capturedLinesCerr() == std::vector{ "[line 1] Error at '+': Cannot concatenate 2.0 and Nil."s });
+    }
+
+    TEST_CASE("Counted loops behave like the loops they were fused from.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        TestGuard guard;
+        REQUIRE(RunWitoutGuard(engine, "var s = 0; for (var i = 0; i < 5; i = i + 1) s = s + i; s;") == Object(10.0));
+        REQUIRE(RunWitoutGuard(engine, "fun f() { var s = 0; for (var i = 0; i < 5; i = i + 1) s = s + i; return s; } f();") == Object(10.0));
+        REQUIRE(RunWitoutGuard(engine, "fun f() { for (var i = 10; i > 0; i = i - 3) if (i < 5) return i; } f();") == Object(4.0));
+        REQUIRE(RunWitoutGuard(engine, "var t = \"a\"; t = t + 1; t;") == Object("a1.0"s));
+        REQUIRE(RunWitoutGuard(engine, "fun f() { var t = \"a\"; t = t + 1; return t; } f();") == Object("a1.0"s));
+        REQUIRE(RunWitoutGuard(engine, "for (var i = \"a\"; i < 3; i = i + 1) {}") == Object("Interpreter error"s));
+        Lox::hadError = false;
+        REQUIRE(RunWitoutGuard(engine, "fun f() { var n; n = n - 1; } f();") == Object("Interpreter error"s));
+        REQUIRE(guard.capturedLinesCerr() == std::vector{ "[line 1] Error at '<': Operands must be numbers."s, "[line 1] Error at '-': Operands must be numbers."s });
+    }
+
+    TEST_CASE("Numbers print as the shortest text that reads back as them.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        TestGuard guard;
+        RunWitoutGuard(engine, "print 3; print -2.5; print 0.1 + 0.2; print 1 / 3; print 0.0000001; print 1000000000000000000000; print 123456789012; print 1 / 0;"
+            "var s = \"\"; s = s + 0.5 + \" \" + 100; print s;");
+        REQUIRE(guard.capturedLinesCout() == std::vector{ "3.0"s, "-2.5"s, "0.30000000000000004"s, "0.3333333333333333"s, "1e-07"s,
+            "1e+21"s, "123456789012.0"s, "inf"s, "0.5 100.0"s });
+    }
+
+    TEST_CASE("Closures share captured variables.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        auto const script = "\
+fun makePair() {\
+    var n = 0;\
+    fun inc() { n = n + 1; return n; }\
+    fun get() { return n; }\
+    inc();\
+    inc();\
+    return get;\
+}\
+makePair()();";
+        REQUIRE(RunWithGuard(engine, script) == Object(2.0));
+    }
+
+    TEST_CASE("Nested closures capture through enclosing functions.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        auto const script = "\
+fun outer() {\
+    var x = \"outer\";\
+    fun middle() {\
+        fun inner() { return x; }\
+        return inner;\
+    }\
+    return middle;\
+}\
+outer()()();";
+        REQUIRE(RunWithGuard(engine, script) == Object("outer"s));
+    }
+
+    TEST_CASE("Runtime errors report the operator token.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        TestGuard guard;
+        REQUIRE(RunWitoutGuard(engine, "1 - \"a\";") == Object("Interpreter error"s));
+        REQUIRE(guard.capturedLinesCerr() == std::vector{ "[line 1] Error at '-': Operands must be numbers."s });
+    }
+
+    TEST_CASE("Calling with wrong number of arguments is an error.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        TestGuard guard;
+        REQUIRE(RunWitoutGuard(engine, "fun f(a) {} f();") == Object("Interpreter error"s));
+        REQUIRE(guard.capturedLinesCerr() == std::vector{ "[line 1] Error at ')': Expected 1 arguments but got 0."s });
+    }
+
+    TEST_CASE("Declarations in a counted loop's body are scoped to one iteration.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        TestGuard guard;
+        REQUIRE(RunWitoutGuard(engine, "fun f() { var i = 0; while (i < 3) { var x = i * 10; i = i + 1; } var y = 42; return y; } f();") == Object(42.0));
+        REQUIRE(RunWitoutGuard(engine, "fun f() { var i = 0; while (i < 3) { fun g() { return i; } i = i + 1; } var y = 42; return y; } f();") == Object(42.0));
+        REQUIRE(RunWitoutGuard(engine, 
+            "fun f() { var first; var second;"
+            "  for (var i = 0; i < 2; i = i + 1) { var v = i * 10; fun g() { return v; } if (first == nil) first = g; else second = g; }"
+            "  return first() + second(); } f();") == Object(10.0));
+        REQUIRE(RunWitoutGuard(engine, "var m = 0; while (m < 2) { var leaked = m; m = m + 1; } leaked;") == Object("Interpreter error"s));
+        REQUIRE(guard.capturedLinesCerr() == std::vector{ "[line 1] Error at 'leaked': Undefined variable 'leaked'."s });
+    }
+
+    TEST_CASE("Handlers release the values they pop.") {
+        auto const engine = GENERATE(Engine::TREE_WALKER, Engine::VM);
+        TestGuard guard;
+        REQUIRE(RunWitoutGuard(engine, "fun f() { for (var i = 0; i < 10; i = i + 1) { var t = \"s\" + i; var u = \"p\" + t; } } f();") == Object());
+        auto const interned = Symbol::internedCount();
+        REQUIRE(RunWitoutGuard(engine, 
+            "fun f() { for (var i = 0; i < 1000; i = i + 1) {"
+            "  var t = \"s\" + i; var u = \"p\" + t; var same = t == u;"
+            "  fun g() { return t; } class A { m() { return u; } } } } f();") == Object());
+        // Closures that captured the strings hold them until they are collected.
+        auto const root = Lox::heap.root(Lox::globals);
+        Lox::heap.collect();
+        REQUIRE(Symbol::internedCount() < interned + 100);
+    }
+
 }
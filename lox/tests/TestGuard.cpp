@@ -42,6 +42,6 @@ TestGuard::~TestGuard() {
     }
 
     Lox::globals = Environment();
-    Lox::locals.clear();
+    Lox::heap.collect();
     Lox::hadError = false;
 }
@@ -0,0 +1,101 @@
+#include "Scanner.h"
+#include "Parser.h"
+#include "Resolver.h"
+#include "Interpreter.h"
+#include "Environment.h"
+#include "Heap.h"
+#include "Object.h"
+#include "Lox.h"
+#include "Token.h"
+#include "TokenType.h"
+#include "TestGuard.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+namespace {
+
+    TEST_CASE("Collection frees unreachable environments") {
+        TestGuard guard;
+        auto const before = Lox::heap.stats();
+        Lox::heap.allocate<Environment>();
+        Lox::heap.collect();
+        REQUIRE(Lox::heap.stats().objectsFreed == before.objectsFreed + 1);
+        REQUIRE(Lox::heap.stats().liveObjects() == before.liveObjects());
+    }
+
+    TEST_CASE("Rooted environments and everything they reach survive collection") {
+        TestGuard guard;
+        auto const environment = Lox::heap.allocate<Environment>();
+        auto const instance = LoxInstance(LoxClass("A", std::nullopt, {}));
+        environment->define(Symbol("a"), instance);
+        auto const before = Lox::heap.stats();
+        {
+            auto const root = Lox::heap.root(*environment);
+            Lox::heap.collect();
+            REQUIRE(Lox::heap.stats().objectsFreed == before.objectsFreed);
+            REQUIRE(environment->get(Token(TokenType::IDENTIFIER, "a", 0)) == Object(instance));
+        }
+        Lox::heap.collect();
+        // The environment, the instance and its class.
+        REQUIRE(Lox::heap.stats().objectsFreed == before.objectsFreed + 3);
+    }
+
+    TEST_CASE("Direct method calls do not allocate bound methods") {
+        TestGuard guard;
+        auto const allocations = [](std::string const& source) {
+            auto const before = Lox::heap.stats().objectsAllocated;
+            auto const text = "class A { f() { return 1; } } var a = A();" + source;
+            auto const program = parse(scanTokens(text));
+            resolve(program.statements());
+            interpret(program.statements());
+            REQUIRE(!Lox::hadError);
+            return Lox::heap.stats().objectsAllocated - before;
+        };
+        auto const direct = allocations("for (var i = 0; i < 100; i = i + 1) { a.f(); }");
+        auto const bound = allocations("for (var i = 0; i < 100; i = i + 1) { var f = a.f; f(); }");
+        REQUIRE(bound - direct == 100);
+    }
+
+    TEST_CASE("Calls allocate on the heap only for variables closures capture") {
+        TestGuard guard;
+        auto const declarations = parse(scanTokens(
+            "fun fib(n) { if (n < 2) return n; return fib(n - 2) + fib(n - 1); }\n"
+            "fun counter() { var count = 0; fun next() { count = count + 1; return count; } return next; }\n"));
+        resolve(declarations.statements());
+        interpret(declarations.statements());
+        auto const allocations = [](std::string const& source) {
+            auto const before = Lox::heap.stats().objectsAllocated;
+            auto const program = parse(scanTokens(source));
+            resolve(program.statements());
+            interpret(program.statements());
+            REQUIRE(!Lox::hadError);
+            return Lox::heap.stats().objectsAllocated - before;
+        };
+        REQUIRE(allocations("fib(15);") == 0);
+        // The cell holding count, the closure and the function.
+        REQUIRE(allocations("counter();") == 3);
+    }
+
+    TEST_CASE("Long running scripts do not accumulate garbage") {
+        TestGuard guard;
+        auto const source = std::string(
+            "class Node { init(next) { this.next = next; } }\n"
+            "var list = nil;\n"
+            "for (var i = 0; i < 20000; i = i + 1) { var node = Node(nil); node.next = node; list = Node(list); }\n");
+        auto const program = parse(scanTokens(source));
+        auto const& statements = program.statements();
+        resolve(statements);
+        interpret(statements);
+        REQUIRE(!Lox::hadError);
+        REQUIRE(Lox::heap.stats().collections > 0);
+
+        // The list held by a global is still alive, the self-referencing nodes are not.
+        auto const root = Lox::heap.root(Lox::globals);
+        Lox::heap.collect();
+        auto const& stats = Lox::heap.stats();
+        REQUIRE(stats.liveObjects() < stats.objectsAllocated / 2);
+        REQUIRE(stats.liveObjects() >= 20000);
+    }
+
+}
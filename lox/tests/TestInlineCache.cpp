@@ -0,0 +1,98 @@
+#include "Scanner.h"
+#include "Parser.h"
+#include "Resolver.h"
+#include "Interpreter.h"
+#include "InlineCache.h"
+#include "Object.h"
+#include "Lox.h"
+#include "Environment.h"
+#include "Token.h"
+#include "Source.h"
+#include "TestGuard.h"
+#include "LogListener.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+using namespace std::string_literals;
+
+namespace {
+
+    // Later scripts may call functions declared by earlier ones.
+    std::vector<Program> programs;
+
+    Object run(std::string const& source) {
+        auto& program = programs.emplace_back(parse(Source(source)));
+        resolve(program.statements());
+        auto const result = interpret(program.statements());
+        REQUIRE(!Lox::hadError);
+        return result;
+    }
+
+    TEST_CASE("Monomorphic call sites hit the cache") {
+        TestGuard guard;
+        auto const before = InlineCache::stats;
+        REQUIRE(run("class A { f() { return 1; } } var a = A(); var s = 0; for (var i = 0; i < 100; i = i + 1) s = s + a.f(); s;") == Object(100.0));
+        REQUIRE(InlineCache::stats.misses - before.misses <= 2);
+        REQUIRE(InlineCache::stats.hits - before.hits >= 99);
+    }
+
+    TEST_CASE("Polymorphic and megamorphic call sites find the right method") {
+        TestGuard guard;
+        LogListener listener;
+        run("\
+class A { f() { return 1; } }\
+class B < A { }\
+class C { f() { return 3; } }\
+class D { f() { return 4; } }\
+class E { f() { return 5; } }\
+class F < E { f() { return 6; } }\
+fun call(x) { log(x.f()); }\
+for (var i = 0; i < 2; i = i + 1) { call(A()); call(B()); call(C()); call(D()); call(E()); call(F()); }");
+        REQUIRE(listener.history() == std::vector<Object>{1.0, 1.0, 3.0, 4.0, 5.0, 6.0, 1.0, 1.0, 3.0, 4.0, 5.0, 6.0});
+    }
+
+    TEST_CASE("Fields shadow cached methods") {
+        TestGuard guard;
+        LogListener listener;
+        run("\
+class A { f() { return 1; } }\
+fun g() { return 2; }\
+fun call(x) { log(x.f()); }\
+var a = A();\
+var b = A();\
+call(a);\
+b.f = g;\
+call(b);\
+call(a);");
+        REQUIRE(listener.history() == std::vector<Object>{1.0, 2.0, 1.0});
+    }
+
+    TEST_CASE("Property sites handle instances with different layouts") {
+        TestGuard guard;
+        LogListener listener;
+        run("\
+class P { init(first) { if (first) { this.a = 1; this.b = 2; } else { this.b = 3; this.a = 4; } } }\
+class Q { init() { this.b = 5; } }\
+fun show(p) { log(p.a); }\
+fun bump(p) { p.b = p.b + 10; log(p.b); }\
+for (var i = 0; i < 2; i = i + 1) { var p = P(true); var r = P(false); show(p); show(r); bump(p); bump(r); bump(Q()); }");
+        REQUIRE(listener.history() == std::vector<Object>{1.0, 4.0, 12.0, 13.0, 15.0, 1.0, 4.0, 12.0, 13.0, 15.0});
+    }
+
+    TEST_CASE("Caches are emptied when a class is freed") {
+        TestGuard guard;
+        run("class A { f() { return 1; } } var a = A(); fun call() { return a.f(); } call();");
+        auto const before = InlineCache::stats;
+        run("call();");
+        REQUIRE(InlineCache::stats.hits == before.hits + 1);
+        run("{ class B {} }");
+        {
+            auto const root = Lox::heap.root(Lox::globals);
+            Lox::heap.collect();
+        }
+        run("call();");
+        REQUIRE(InlineCache::stats.misses == before.misses + 1);
+    }
+
+}
@@ -11,7 +11,7 @@ using namespace std::string_literals;
 
 namespace {
 
-    auto const identifier = Token(TokenType::IDENTIFIER, "TestClass", Object(), 0);
+    auto const identifier = Token(TokenType::IDENTIFIER, "TestClass", 0);
     auto const dummy = identifier;
     auto const declareClass = ClassStmt(identifier, nullptr, {});
     auto const variable = VariableExpr(identifier);
@@ -23,4 +23,18 @@ namespace {
         REQUIRE(!Lox::hadError);
     }
 
+    TEST_CASE("Binary expressions are quickened while they see numbers") {
+        auto const plus = Token(TokenType::PLUS, "+", 0);
+        auto const one = LiteralExpr(1.0);
+        auto const string = LiteralExpr(Object("a"s));
+        auto const addNumbers = BinaryExpr(&one, plus, &one);
+        auto const addString = BinaryExpr(&addNumbers, plus, &string);
+        auto const statement = ExpressionStmt(&addString);
+
+        REQUIRE(interpret({ &statement }) == Object("2.0a"s));
+        REQUIRE(addNumbers.kind() == ExprKind::NUMBER_BINARY);
+        REQUIRE(addString.kind() == ExprKind::BINARY);
+        REQUIRE(!Lox::hadError);
+    }
+
 }
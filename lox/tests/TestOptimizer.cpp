@@ -0,0 +1,115 @@
+#include "Stmt.h"
+#include "Expr.h"
+#include "Lox.h"
+#include "Resolver.h"
+#include "Optimizer.h"
+#include "Interpreter.h"
+#include "Scanner.h"
+#include "Parser.h"
+#include "StmtToString.h"
+#include "TestGuard.h"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+
+    // The optimized program, one statement per line.
+    std::string optimized(Program& program) {
+        resolve(program.statements());
+        REQUIRE(!Lox::hadError);
+        optimize(program);
+        auto result = std::string();
+        for (auto const* statement : program.statements()) {
+            result += (result.empty() ? "" : "\n") + toString(*statement);
+        }
+        return result;
+    }
+
+    std::string optimized(std::string const& source) {
+        auto program = parse(scanTokens(source));
+        return optimized(program);
+    }
+
+    TEST_CASE("Operators on literals are folded") {
+        TestGuard guard;
+        REQUIRE(optimized("print 1 + 2 * 3;") == "(print 7.0)");
+        REQUIRE(optimized("print -(1 + 2);") == "(print -3.0)");
+        REQUIRE(optimized("print !true;") == "(print false)");
+        REQUIRE(optimized("print !nil == (1 < 2);") == "(print true)");
+        REQUIRE(optimized("print \"a\" + 1;") == "(print \"a1.0\")");
+    }
+
+    TEST_CASE("Operators that fail at run time are not folded") {
+        TestGuard guard;
+        REQUIRE(optimized("print \"a\" - 1;") == "(print (- \"a\" 1.0))");
+        REQUIRE(optimized("print -nil;") == "(print (- nil))");
+        REQUIRE(optimized("print true + 1;") == "(print (+ true 1.0))");
+    }
+
+    TEST_CASE("Logical operators with a literal left operand are decided") {
+        TestGuard guard;
+        REQUIRE(optimized("var x; print nil or x;") == "(var x nil)\n(print x)");
+        REQUIRE(optimized("var x; print 1 or x;") == "(var x nil)\n(print 1.0)");
+        REQUIRE(optimized("var x; print false and x;") == "(var x nil)\n(print false)");
+        REQUIRE(optimized("var x; print x and 1 + 1;") == "(var x nil)\n(print (and x 2.0))");
+    }
+
+    TEST_CASE("String literals concatenated in a row are joined") {
+        TestGuard guard;
+        REQUIRE(optimized("var x; print x + \"a\" + \"b\" + \"c\";") == "(var x nil)\n(print (+ x \"abc\"))");
+        REQUIRE(optimized("var x; print \"a\" + \"b\" + x;") == "(var x nil)\n(print (+ \"ab\" x))");
+    }
+
+    TEST_CASE("Branches ruled out by a literal condition are removed") {
+        TestGuard guard;
+        REQUIRE(optimized("if (1 < 2) print 1; else print 2;") == "(print 1.0)");
+        REQUIRE(optimized("if (!true) print 1; else print 2;") == "(print 2.0)");
+        REQUIRE(optimized("if (false) print 1; print 3;") == "(print 3.0)");
+        REQUIRE(optimized("while (false) print 1; print 3;") == "(print 3.0)");
+        REQUIRE(optimized("while (true) if (false) print 1;") == "(while true (block))");
+        REQUIRE(optimized("if (nil) print 1; else print 2;") == "(print 2.0)");
+        REQUIRE(optimized("if (\"a\") print 1;") == "(print 1.0)");
+        REQUIRE(optimized("while (nil) print 1; print 3;") == "(print 3.0)");
+    }
+
+    TEST_CASE("A for loop without a condition is endless") {
+        TestGuard guard;
+        auto program = parse(scanTokens("for (;;) print 1;"));
+        optimized(program);
+        REQUIRE(static_cast<WhileStmt const&>(*program.statements().front()).isEndless());
+    }
+
+    TEST_CASE("Adding a constant to a variable is fused") {
+        TestGuard guard;
+        REQUIRE(optimized("var x = 1; x = x + 1;") == "(var x 1.0)\n(; (+= x 1.0))");
+        REQUIRE(optimized("var x = 1; x = x * (2 + 1);") == "(var x 1.0)\n(; (*= x 3.0))");
+        REQUIRE(optimized("var x = 1; var y; x = y + 1;") == "(var x 1.0)\n(var y nil)\n(; (= x (+ y 1.0)))");
+        REQUIRE(optimized("var x = 1; x = 1 + x;") == "(var x 1.0)\n(; (= x (+ 1.0 x)))");
+        REQUIRE(optimized("var x = 1; x = x + \"a\";") == "(var x 1.0)\n(; (= x (+ x \"a\")))");
+    }
+
+    TEST_CASE("A for loop stepping its counter by a constant is a counted loop") {
+        TestGuard guard;
+        REQUIRE(optimized("for (var i = 0; i < 3; i = i + 1) print i;")
+            == "(block (var i 0.0) (for (< i 3.0) (+= i 1.0) (print i)))");
+        REQUIRE(optimized("var n = 3; for (var i = n; i >= 0; i = i - 1) print i;")
+            == "(var n 3.0)\n(block (var i n) (for (>= i 0.0) (-= i 1.0) (print i)))");
+        REQUIRE(optimized("var i = 0; while (i < 3) { var x = i; i = i + 1; }")
+            == "(var i 0.0)\n(for (< i 3.0) (+= i 1.0) (block (var x i)))");
+        // The increment must step the variable the condition tests.
+        REQUIRE(optimized("var j = 0; for (var i = 0; j < 3; i = i + 1) print i;").ends_with("(while (< j 3.0) (block (print i) (; (+= i 1.0)))))"));
+    }
+
+    TEST_CASE("Rebuilt declarations keep the slots the resolver gave them") {
+        TestGuard guard;
+        auto program = parse(scanTokens(
+            "class A { init() { this.x = 2 * 3; } get(n) { var y = n + 1 * 1; return this.x + y; } }"
+            "fun f(a) { fun g() { return a + (2 - 1); } return g; }"
+            "A().get(f(1)());"));
+        REQUIRE(optimized(program).starts_with("(class A (fun init () (; (= (. this x) 6.0)))"));
+        REQUIRE(interpret(program.statements()) == Object(9.0));
+        REQUIRE(!Lox::hadError);
+    }
+
+}
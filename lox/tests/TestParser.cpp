@@ -10,29 +10,40 @@ using namespace std::string_literals;
 
 namespace {
 
-    auto const tSEMICOLON = Token(TokenType::SEMICOLON, ";", Object(), 0);
-    auto const tEND_OF_FILE = Token(TokenType::END_OF_FILE, "", Object(), 0);
+    auto const tSEMICOLON = Token(TokenType::SEMICOLON, ";", 0);
+    auto const tEND_OF_FILE = Token(TokenType::END_OF_FILE, "", 0);
 
-    auto const tPRINT = Token(TokenType::PRINT, "print", Object(), 0);
-    auto const tNUMBER = Token(TokenType::NUMBER, "3", Object(3.0), 0);
+    auto const tPRINT = Token(TokenType::PRINT, "print", 0);
+    auto const tNUMBER = Token(TokenType::NUMBER, "3", 0);
     
-    auto const tVAR = Token(TokenType::VAR, "print", Object(), 0);
-    auto const tIDENTIFIER = Token(TokenType::IDENTIFIER, "test", Object(), 0);
-    auto const tEQUAL = Token(TokenType::EQUAL, "=", Object(), 0);
-    auto const tSTRING = Token(TokenType::STRING, "Test", Object("Test"s), 0);
+    auto const tVAR = Token(TokenType::VAR, "print", 0);
+    auto const tIDENTIFIER = Token(TokenType::IDENTIFIER, "test", 0);
+    auto const tEQUAL = Token(TokenType::EQUAL, "=", 0);
+    auto const tSTRING = Token(TokenType::STRING, "\"Test\"", 0);
     
     TEST_CASE("Parser produces print statement") {
         auto const printNumber = parse({ tPRINT, tNUMBER, tSEMICOLON, tEND_OF_FILE });
         REQUIRE(!Lox::hadError);
-        REQUIRE(printNumber.size() == 1);
-        REQUIRE(dynamic_cast<PrintStmt const*>(printNumber.front()));
+        REQUIRE(printNumber.statements().size() == 1);
+        REQUIRE(dynamic_cast<PrintStmt const*>(printNumber.statements().front()));
     }
 
     TEST_CASE("Parser produces var statement") {
         auto const printNumber = parse({ tVAR, tIDENTIFIER, tEQUAL, tSTRING, tSEMICOLON, tEND_OF_FILE });
         REQUIRE(!Lox::hadError);
-        REQUIRE(printNumber.size() == 1);
-        REQUIRE(dynamic_cast<VarStmt const*>(printNumber.front()));
+        REQUIRE(printNumber.statements().size() == 1);
+        REQUIRE(dynamic_cast<VarStmt const*>(printNumber.statements().front()));
+    }
+
+    TEST_CASE("Parsed nodes are allocated from the program") {
+        auto program = parse({ tVAR, tIDENTIFIER, tEQUAL, tSTRING, tSEMICOLON, tPRINT, tNUMBER, tSEMICOLON, tEND_OF_FILE });
+        REQUIRE(!Lox::hadError);
+        REQUIRE(program.bytesAllocated() >= sizeof(VarStmt) + sizeof(PrintStmt));
+        REQUIRE(!program.declaresFunctions());
+
+        auto const moved = Program(std::move(program));
+        REQUIRE(moved.statements().size() == 2);
+        REQUIRE(program.statements().empty());
     }
 
 }
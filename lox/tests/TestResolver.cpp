@@ -5,6 +5,8 @@
 #include "Expr.h"
 #include "Lox.h"
 #include "Resolver.h"
+#include "Scanner.h"
+#include "Parser.h"
 #include "TestGuard.h"
 #include <catch2/catch_test_macros.hpp>
 
@@ -12,7 +14,7 @@ using namespace std::string_literals;
 
 namespace {
 
-    auto const identifier = Token(TokenType::IDENTIFIER, "test", Object(), 0);
+    auto const identifier = Token(TokenType::IDENTIFIER, "test", 0);
     auto const declareVariable = VarStmt(identifier, nullptr);
     auto const variableExpr = VariableExpr(identifier);
     auto const useVariable = ExpressionStmt(&variableExpr);
@@ -26,13 +28,16 @@ namespace {
         auto const block = BlockStmt({ &declareVariable });
         resolve({ &block });
         REQUIRE(!Lox::hadError);
+        REQUIRE(declareVariable.slot().kind == VariableSlot::Kind::LOCAL);
+        REQUIRE(declareVariable.slot().index == 0);
     }
 
     TEST_CASE("Using a global variable does not produce any locals") {
         TestGuard guard;
         resolve({ &declareVariable, &useVariable });
         REQUIRE(!Lox::hadError);
-        REQUIRE(Lox::locals .empty());
+        REQUIRE(declareVariable.slot().isGlobal());
+        REQUIRE(variableExpr.slot().isGlobal());
     }
 
     TEST_CASE("Using a variable in block procudes a resolved local") {
@@ -40,7 +45,8 @@ namespace {
         auto const block = BlockStmt({ &declareVariable, &useVariable });
         resolve({ &block });
         REQUIRE(!Lox::hadError);
-        REQUIRE(Lox::locals.contains(&variableExpr));        
+        REQUIRE(variableExpr.slot().kind == VariableSlot::Kind::LOCAL);
+        REQUIRE(variableExpr.slot().index == 0);
     }
 
     TEST_CASE("Assigning a varable produces local") {
@@ -48,7 +54,84 @@ namespace {
         auto const block = BlockStmt({ &declareVariable, &assignStmt });
         resolve({ &block });
         REQUIRE(!Lox::hadError);
-        REQUIRE(Lox::locals.contains(&assignExpr));
+        REQUIRE(assignExpr.slot().kind == VariableSlot::Kind::LOCAL);
+        REQUIRE(assignExpr.slot().index == 0);
+    }
+
+    TEST_CASE("Declarations in nested blocks get consecutive slots of the same frame") {
+        TestGuard guard;
+        auto const other = Token(TokenType::IDENTIFIER, "other", 0);
+        auto const declareOther = VarStmt(other, nullptr);
+        auto const useOther = VariableExpr(other);
+        auto const useOtherStmt = ExpressionStmt(&useOther);
+        auto const inner = BlockStmt({ &useOtherStmt });
+        auto const block = BlockStmt({ &declareVariable, &declareOther, &inner });
+        resolve({ &block });
+        REQUIRE(!Lox::hadError);
+        REQUIRE(declareVariable.slot().index == 0);
+        REQUIRE(declareOther.slot().index == 1);
+        REQUIRE(useOther.slot().kind == VariableSlot::Kind::LOCAL);
+        REQUIRE(useOther.slot().index == 1);
+    }
+
+    FunctionStmt const& resolveFunction(Program const& program) {
+        resolve(program.statements());
+        REQUIRE(!Lox::hadError);
+        return static_cast<FunctionStmt const&>(*program.statements().front());
+    }
+
+    TEST_CASE("Sibling blocks reuse the slots of a function's frame") {
+        TestGuard guard;
+        auto const program = parse(scanTokens("fun f(p) { { var a; } { var b; var c; } }"));
+        auto const& function = resolveFunction(program);
+        auto const& body = function.body().statements();
+        auto const& first = static_cast<BlockStmt const&>(*body[0]).statements();
+        auto const& second = static_cast<BlockStmt const&>(*body[1]).statements();
+        REQUIRE(static_cast<VarStmt const&>(*first[0]).slot().index == 1);
+        REQUIRE(static_cast<VarStmt const&>(*second[0]).slot().index == 1);
+        REQUIRE(static_cast<VarStmt const&>(*second[1]).slot().index == 2);
+        REQUIRE(function.layout().slotCount == 3);
+        REQUIRE(function.layout().cellCount == 0);
+        REQUIRE(function.layout().captures.empty());
+    }
+
+    TEST_CASE("Only variables captured by a closure are boxed in cells") {
+        TestGuard guard;
+        auto const program = parse(scanTokens("fun outer() { var a = 1; var b = a; fun inner() { return a; } return b; }"));
+        auto const& outer = resolveFunction(program);
+        auto const& body = outer.body().statements();
+        auto const& a = static_cast<VarStmt const&>(*body[0]);
+        auto const& b = static_cast<VarStmt const&>(*body[1]);
+        auto const& inner = static_cast<FunctionStmt const&>(*body[2]);
+        auto const& readInB = static_cast<VariableExpr const&>(*b.initializer());
+        auto const& readInInner = static_cast<VariableExpr const&>(*static_cast<ReturnStmt const&>(*inner.body().statements()[0]).value());
+
+        REQUIRE(a.slot().kind == VariableSlot::Kind::CELL);
+        REQUIRE(readInB.slot().kind == VariableSlot::Kind::CELL);
+        REQUIRE(b.slot().kind == VariableSlot::Kind::LOCAL);
+        REQUIRE(inner.slot().kind == VariableSlot::Kind::LOCAL);
+        REQUIRE(readInInner.slot().kind == VariableSlot::Kind::UPVALUE);
+        REQUIRE(readInInner.slot().index == 0);
+        REQUIRE(outer.layout().cellCount == 1);
+        REQUIRE(inner.layout().captures.size() == 1);
+        REQUIRE(inner.layout().captures[0].fromCell);
+        REQUIRE(inner.layout().captures[0].index == a.slot().index);
+    }
+
+    TEST_CASE("Captured parameters are boxed when the function is called") {
+        TestGuard guard;
+        auto const program = parse(scanTokens("fun f(p, q) { fun g() { fun h() { return q; } } }"));
+        auto const& f = resolveFunction(program);
+        auto const& g = static_cast<FunctionStmt const&>(*f.body().statements()[0]);
+        auto const& h = static_cast<FunctionStmt const&>(*g.body().statements()[0]);
+        REQUIRE(f.layout().capturedParameters.size() == 1);
+        REQUIRE(f.layout().capturedParameters[0].slot == 1);
+        REQUIRE(f.layout().capturedParameters[0].cell == 0);
+        REQUIRE(g.layout().captures.size() == 1);
+        REQUIRE(g.layout().captures[0].fromCell);
+        REQUIRE(h.layout().captures.size() == 1);
+        REQUIRE(!h.layout().captures[0].fromCell);
+        REQUIRE(h.layout().captures[0].index == 0);
     }
 
 }
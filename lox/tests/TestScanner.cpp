@@ -4,6 +4,11 @@
 #include "Lox.h"
 #include <catch2/catch_test_macros.hpp>
 #include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+
+using namespace std::string_literals;
 
 namespace {
 
@@ -18,4 +23,103 @@ namespace {
         REQUIRE(!Lox::hadError);
     }
 
+    TEST_CASE("Tokens are views into the source") {
+        auto const source = std::string("var answer = 42;");
+        auto const tokens = scanTokens(source);
+        REQUIRE(!Lox::hadError);
+        REQUIRE(tokens[1].lexeme() == "answer");
+        REQUIRE(tokens[1].lexeme().data() == source.data() + 4);
+        REQUIRE(tokens[1].symbol() == Symbol("answer"));
+    }
+
+    TEST_CASE("Literal values are decoded from the lexeme") {
+        auto const tokens = scanTokens("12.5 \"a\nb\" x");
+        REQUIRE(!Lox::hadError);
+        REQUIRE(tokens[0].literal() == Object(12.5));
+        REQUIRE(tokens[1].lexeme() == "\"a\nb\"");
+        REQUIRE(tokens[1].literal() == Object("a\nb"s));
+        REQUIRE(tokens[2].line() == 2);
+        REQUIRE(tokens[2].literal().isNil());
+    }
+
+    TEST_CASE("Number literals too large or small for a double") {
+        auto const source = "1" + std::string(400, '0') + " 0." + std::string(400, '0') + "1 0" + std::string(400, '1')
+            + " 00." + std::string(400, '0') + "1";
+        auto const tokens = scanTokens(source);
+        REQUIRE(!Lox::hadError);
+        REQUIRE(tokens[0].literal() == Object(std::numeric_limits<double>::infinity()));
+        REQUIRE(tokens[1].literal() == Object(0.0));
+        REQUIRE(tokens[2].literal() == Object(std::numeric_limits<double>::infinity()));
+        REQUIRE(tokens[3].literal() == Object(0.0));
+    }
+
+    TEST_CASE("Every keyword is recognized at compile time") {
+        STATIC_REQUIRE(keywordType("and") == TokenType::AND);
+        STATIC_REQUIRE(keywordType("class") == TokenType::CLASS);
+        STATIC_REQUIRE(keywordType("else") == TokenType::ELSE);
+        STATIC_REQUIRE(keywordType("false") == TokenType::FALSE);
+        STATIC_REQUIRE(keywordType("for") == TokenType::FOR);
+        STATIC_REQUIRE(keywordType("fun") == TokenType::FUN);
+        STATIC_REQUIRE(keywordType("if") == TokenType::IF);
+        STATIC_REQUIRE(keywordType("nil") == TokenType::NIL);
+        STATIC_REQUIRE(keywordType("or") == TokenType::OR);
+        STATIC_REQUIRE(keywordType("print") == TokenType::PRINT);
+        STATIC_REQUIRE(keywordType("DEBUG") == TokenType::ENABLE_DEBUG);
+        STATIC_REQUIRE(keywordType("return") == TokenType::RETURN);
+        STATIC_REQUIRE(keywordType("super") == TokenType::SUPER);
+        STATIC_REQUIRE(keywordType("this") == TokenType::THIS);
+        STATIC_REQUIRE(keywordType("true") == TokenType::TRUE);
+        STATIC_REQUIRE(keywordType("var") == TokenType::VAR);
+        STATIC_REQUIRE(keywordType("while") == TokenType::WHILE);
+    }
+
+    TEST_CASE("Identifiers that resemble keywords are not keywords") {
+        STATIC_REQUIRE(keywordType("a") == TokenType::IDENTIFIER);
+        STATIC_REQUIRE(keywordType("an") == TokenType::IDENTIFIER);
+        STATIC_REQUIRE(keywordType("ands") == TokenType::IDENTIFIER);
+        STATIC_REQUIRE(keywordType("Class") == TokenType::IDENTIFIER);
+        STATIC_REQUIRE(keywordType("debug") == TokenType::IDENTIFIER);
+        STATIC_REQUIRE(keywordType("fon") == TokenType::IDENTIFIER);
+        STATIC_REQUIRE(keywordType("whale") == TokenType::IDENTIFIER);
+        REQUIRE(scanTokens("var vars").at(1).tokenType() == TokenType::IDENTIFIER);
+        REQUIRE(!Lox::hadError);
+    }
+
+    TEST_CASE("Runs longer than a block are scanned whole") {
+        auto const name = std::string(40, 'a') + "Z9";
+        auto const digits = std::string(37, '7');
+        auto const source = "\t\r\n" + std::string(20, ' ') + "\n  " + name + "+" + digits + "." + digits
+            + " // " + std::string(50, '/') + "\n" + std::string(17, '\n') + "x";
+        auto const tokens = scanTokens(source);
+        REQUIRE(!Lox::hadError);
+        REQUIRE(tokens.size() == 5);
+        REQUIRE(tokens[0].lexeme() == name);
+        REQUIRE(tokens[0].line() == 3);
+        REQUIRE(tokens[2].lexeme() == digits + "." + digits);
+        REQUIRE(tokens[3].lexeme() == "x");
+        REQUIRE(tokens[3].line() == 21);
+    }
+
+    TEST_CASE("Identifiers stop at characters outside ASCII") {
+        auto const tokens = scanTokens("abcdefghijklmnopqrstuvwxyz_0");
+        REQUIRE(Lox::hadError);
+        Lox::hadError = false;
+        REQUIRE(tokens[0].lexeme() == "abcdefghijklmnopqrstuvwxyz");
+        REQUIRE(tokens[1].lexeme() == "0");
+
+        REQUIRE(scanTokens("abcdefghijklmnopqrstuvwxyz\xC3\xA9").front().lexeme() == "abcdefghijklmnopqrstuvwxyz");
+        REQUIRE(Lox::hadError);
+        Lox::hadError = false;
+    }
+
+    TEST_CASE("A scanner hands out tokens one at a time") {
+        auto scanner = Scanner("print 1;");
+        REQUIRE(scanner.next().tokenType() == TokenType::PRINT);
+        REQUIRE(scanner.next().lexeme() == "1");
+        REQUIRE(scanner.next().tokenType() == TokenType::SEMICOLON);
+        REQUIRE(scanner.next().tokenType() == TokenType::END_OF_FILE);
+        REQUIRE(scanner.next().tokenType() == TokenType::END_OF_FILE);
+        REQUIRE(!Lox::hadError);
+    }
+
 }
@@ -0,0 +1,32 @@
+#include "Shape.h"
+#include "Symbol.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+
+    auto const x = Symbol("x");
+    auto const y = Symbol("y");
+
+    TEST_CASE("Empty shape has no fields") {
+        auto const root = Shape();
+        REQUIRE(root.slotCount() == 0);
+        REQUIRE(root.find(x) == -1);
+    }
+
+    TEST_CASE("Adding fields assigns consecutive slots") {
+        auto const root = Shape();
+        auto const shape = root.with(x)->with(y);
+        REQUIRE(shape->slotCount() == 2);
+        REQUIRE(shape->find(x) == 0);
+        REQUIRE(shape->find(y) == 1);
+        REQUIRE(root.with(x)->find(y) == -1);
+    }
+
+    TEST_CASE("Same fields in the same order share a shape") {
+        auto const root = Shape();
+        REQUIRE(root.with(x)->with(y) == root.with(x)->with(y));
+        REQUIRE(root.with(x)->with(y) != root.with(y)->with(x));
+    }
+
+}
@@ -0,0 +1,53 @@
+#include "Source.h"
+#include "Parser.h"
+#include "Program.h"
+#include "Lox.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+
+namespace {
+
+    std::string writeFile(std::string const& name, std::string const& text) {
+        auto const path = (std::filesystem::temp_directory_path() / name).string();
+        std::ofstream(path, std::ios::binary) << text;
+        return path;
+    }
+
+    TEST_CASE("A source keeps its text in place when moved") {
+        auto source = Source(std::string("print 1;"));
+        auto const text = source.text();
+        auto moved = std::move(source);
+        REQUIRE(moved.text() == "print 1;");
+        REQUIRE(moved.text().data() == text.data());
+        REQUIRE(!moved.isMapped());
+    }
+
+    TEST_CASE("A source is read from a file") {
+        auto const path = writeFile("loxSourceTest.lox", "var a = 1;\nprint a;\n");
+        auto source = Source::fromFile(path);
+        REQUIRE(source);
+        REQUIRE(source->text() == "var a = 1;\nprint a;\n");
+
+        auto const program = parse(std::move(*source));
+        REQUIRE(!Lox::hadError);
+        REQUIRE(program.statements().size() == 2);
+        REQUIRE(program.source() == "var a = 1;\nprint a;\n");
+        std::remove(path.c_str());
+    }
+
+    TEST_CASE("Empty and missing files") {
+        auto const path = writeFile("loxEmptySourceTest.lox", "");
+        auto const empty = Source::fromFile(path);
+        REQUIRE(empty);
+        REQUIRE(empty->text().empty());
+        std::remove(path.c_str());
+
+        REQUIRE(!Source::fromFile(path));
+    }
+
+}
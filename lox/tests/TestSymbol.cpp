@@ -0,0 +1,29 @@
+#include "Symbol.h"
+#include "Object.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+using namespace std::string_literals;
+
+namespace {
+
+    TEST_CASE("Equal values intern to the same symbol") {
+        auto const first = Symbol("symbolTest");
+        auto const second = Symbol("symbol"s + "Test");
+        REQUIRE(first == second);
+        REQUIRE(first.entry() == second.entry());
+        REQUIRE(first.hash() == std::hash<std::string_view>()("symbolTest"));
+        REQUIRE(!(first == Symbol("other")));
+    }
+
+    TEST_CASE("String objects share interned entries") {
+        auto const symbol = Symbol("sharedTest");
+        auto const object = Object("shared"s + "Test");
+        REQUIRE(object == Object(symbol));
+        REQUIRE(object == Object("sharedTest"s));
+        REQUIRE(!(object == Object("sharedTest2"s)));
+        REQUIRE(static_cast<std::string>(object) == "sharedTest");
+    }
+
+}